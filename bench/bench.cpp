@@ -0,0 +1,346 @@
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <mr-manager/manager.hpp>
+
+// Run with --benchmark_format=json (or --benchmark_out=<file> --benchmark_out_format=json)
+// to get results that can be compared between runs. Keys and access patterns come
+// from fixed seeds, so two runs of the same binary do the same work.
+
+using namespace mr;
+
+template <std::size_t N, typename Key>
+struct Payload {
+  std::array<std::byte, N> bytes {};
+
+  Payload(int value) noexcept {
+    bytes[0] = static_cast<std::byte>(value);
+  }
+};
+
+template <std::size_t N, typename Key>
+struct mr::AssetId<Payload<N, Key>> { using type = Key; };
+
+// Payload with the liveness bitmap for_each() walks, which costs every create and destroy an atomic
+template <std::size_t N>
+struct IterablePayload : Payload<N, std::string> {
+  using Payload<N, std::string>::Payload;
+};
+
+template <std::size_t N>
+struct mr::AssetId<IterablePayload<N>> { using type = std::string; };
+
+template <std::size_t N>
+struct mr::AssetPolicy<IterablePayload<N>> : mr::DefaultAssetPolicy {
+  static inline constexpr bool iterable = true;
+};
+
+namespace {
+constexpr int key_count = 1 << 16;
+
+template <typename Key>
+const std::vector<Key> & keys() {
+  static const std::vector<Key> keys = [] {
+    std::vector<Key> result;
+    result.reserve(key_count);
+    for (int i = 0; i < key_count; i++) {
+      result.emplace_back(std::string("bench/asset/") + std::to_string(i));
+    }
+    return result;
+  }();
+  return keys;
+}
+
+template <typename Key>
+const std::vector<Key> & missing_keys() {
+  static const std::vector<Key> keys = [] {
+    std::vector<Key> result;
+    result.reserve(key_count);
+    for (int i = 0; i < key_count; i++) {
+      result.emplace_back(std::string("bench/missing/") + std::to_string(i));
+    }
+    return result;
+  }();
+  return keys;
+}
+
+// shuffled indices, a different fixed permutation per thread
+std::vector<int> access_order(int thread_index) {
+  std::vector<int> order(key_count);
+  for (int i = 0; i < key_count; i++) {
+    order[i] = i;
+  }
+  std::ranges::shuffle(order, std::mt19937 {static_cast<unsigned>(thread_index)});
+  return order;
+}
+
+template <typename T>
+void fill(int count) {
+  auto &manager = Manager<T>::get();
+  const auto &ids = keys<asset_id_t<T>>();
+  for (int i = 0; i < count; i++) {
+    manager.create(ids[i], i);
+  }
+}
+
+// records one of every 'stride' operations and reports percentiles as counters
+class LatencySampler {
+public:
+  static inline constexpr int stride = 64;
+
+  template <typename F>
+  void measure(int i, F &&f) {
+    if (i % stride != 0) {
+      f();
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    _samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+  }
+
+  void report(benchmark::State &state) {
+    if (_samples.empty()) {
+      return;
+    }
+    std::ranges::sort(_samples);
+    auto percentile = [&](double p) {
+      return _samples[std::min(_samples.size() - 1, static_cast<std::size_t>(p * _samples.size()))];
+    };
+    state.counters["p50_ns"] = benchmark::Counter(percentile(0.5), benchmark::Counter::kAvgThreads);
+    state.counters["p99_ns"] = benchmark::Counter(percentile(0.99), benchmark::Counter::kAvgThreads);
+    state.counters["p999_ns"] = benchmark::Counter(percentile(0.999), benchmark::Counter::kAvgThreads);
+  }
+
+private:
+  std::vector<double> _samples;
+};
+} // namespace
+
+// create of an absent id per iteration; each thread owns a disjoint share of the keys
+// and erases it (untimed) once all of them are in the table
+template <typename T>
+void BM_Create(benchmark::State &state) {
+  auto &manager = Manager<T>::get();
+  const auto &ids = keys<asset_id_t<T>>();
+  const int threads = state.threads();
+  const int share = key_count / threads;
+  auto key = [&](int i) -> const auto & { return ids[(i % share) * threads + state.thread_index()]; };
+  LatencySampler sampler;
+
+  int i = 0;
+  for (auto _ : state) {
+    if (i % share == 0 && i != 0) {
+      state.PauseTiming();
+      for (int j = 0; j < share; j++) {
+        manager.erase(key(j));
+      }
+      state.ResumeTiming();
+    }
+    sampler.measure(i, [&] {
+      benchmark::DoNotOptimize(manager.create(key(i), i));
+    });
+    i++;
+  }
+
+  sampler.report(state);
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    manager.clear();
+  }
+}
+
+template <typename T>
+void BM_CreateUnnamed(benchmark::State &state) {
+  auto &manager = Manager<T>::get();
+  std::vector<UnnamedId> created;
+  created.reserve(key_count);
+
+  for (auto _ : state) {
+    created.push_back(manager.create(unnamed, 0).id);
+    if (created.size() == key_count) {
+      state.PauseTiming();
+      manager.erase(std::span<const UnnamedId>(created));
+      created.clear();
+      state.ResumeTiming();
+    }
+  }
+
+  manager.erase(std::span<const UnnamedId>(created));
+  state.SetItemsProcessed(state.iterations());
+}
+
+// replaces an existing entry per iteration
+template <typename T>
+void BM_Overwrite(benchmark::State &state) {
+  auto &manager = Manager<T>::get();
+  const auto &ids = keys<asset_id_t<T>>();
+  if (state.thread_index() == 0) {
+    fill<T>(key_count);
+  }
+  auto order = access_order(state.thread_index());
+  LatencySampler sampler;
+
+  int i = 0;
+  for (auto _ : state) {
+    sampler.measure(i, [&] {
+      benchmark::DoNotOptimize(manager.create(ids[order[i % key_count]], i));
+    });
+    i++;
+  }
+
+  sampler.report(state);
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    manager.clear();
+  }
+}
+
+// state.range(0) is the hit ratio in percent
+template <typename T>
+void BM_Find(benchmark::State &state) {
+  auto &manager = Manager<T>::get();
+  const auto &ids = keys<asset_id_t<T>>();
+  const auto &missing = missing_keys<asset_id_t<T>>();
+  if (state.thread_index() == 0) {
+    fill<T>(key_count);
+  }
+  auto order = access_order(state.thread_index());
+  std::vector<bool> hit(key_count);
+  std::mt19937 rng {static_cast<unsigned>(state.thread_index())};
+  for (int i = 0; i < key_count; i++) {
+    hit[i] = static_cast<int>(rng() % 100) < state.range(0);
+  }
+  LatencySampler sampler;
+
+  int i = 0;
+  for (auto _ : state) {
+    int index = order[i % key_count];
+    sampler.measure(i, [&] {
+      benchmark::DoNotOptimize(manager.find(hit[index] ? ids[index] : missing[index]));
+    });
+    i++;
+  }
+
+  sampler.report(state);
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    manager.clear();
+  }
+}
+
+// find_batch() of state.range(0) shuffled ids per iteration, untouched in between, so the
+// lookups miss cache as in a large table
+template <typename T>
+void BM_FindBatch(benchmark::State &state) {
+  auto &manager = Manager<T>::get();
+  const auto &ids = keys<asset_id_t<T>>();
+  fill<T>(key_count);
+  auto order = access_order(0);
+  std::vector<asset_id_t<T>> batch;
+  for (int index : order) {
+    batch.push_back(ids[index]);
+  }
+  auto size = static_cast<std::size_t>(state.range(0));
+  std::vector<std::optional<typename Manager<T>::Handle>> out(size);
+
+  std::size_t offset = 0;
+  for (auto _ : state) {
+    if (offset + size > batch.size()) {
+      offset = 0;
+    }
+    std::span<const asset_id_t<T>> group {batch.data() + offset, size};
+    benchmark::DoNotOptimize(manager.find_batch(group, out));
+    offset += size;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  manager.clear();
+}
+
+// the same ids as BM_FindBatch through one find() each, for comparison
+template <typename T>
+void BM_FindLoop(benchmark::State &state) {
+  auto &manager = Manager<T>::get();
+  const auto &ids = keys<asset_id_t<T>>();
+  fill<T>(key_count);
+  auto order = access_order(0);
+  std::vector<asset_id_t<T>> batch;
+  for (int index : order) {
+    batch.push_back(ids[index]);
+  }
+  auto size = static_cast<std::size_t>(state.range(0));
+
+  std::size_t offset = 0;
+  for (auto _ : state) {
+    if (offset + size > batch.size()) {
+      offset = 0;
+    }
+    for (std::size_t i = offset; i < offset + size; i++) {
+      benchmark::DoNotOptimize(manager.find(batch[i]));
+    }
+    offset += size;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  manager.clear();
+}
+
+// state.range(0) is the number of entries cleared at once
+template <typename T>
+void BM_Clear(benchmark::State &state) {
+  auto &manager = Manager<T>::get();
+  for (auto _ : state) {
+    state.PauseTiming();
+    fill<T>(static_cast<int>(state.range(0)));
+    state.ResumeTiming();
+    manager.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// visits every object once per iteration, through the pool arenas
+template <typename T>
+void BM_ForEach(benchmark::State &state) {
+  auto &manager = Manager<T>::get();
+  fill<T>(key_count);
+  for (auto _ : state) {
+    std::size_t sum = 0;
+    manager.for_each([&](T &value) { sum += static_cast<std::size_t>(value.bytes[0]); });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * key_count);
+  manager.clear();
+}
+
+#define MR_BENCH_THREADS ThreadRange(1, 32)->UseRealTime()
+
+#define MR_BENCH_TYPE(N, Key)                                                                   \
+  BENCHMARK(BM_Create<Payload<N, Key>>)->MR_BENCH_THREADS;                                     \
+  BENCHMARK(BM_Overwrite<Payload<N, Key>>)->MR_BENCH_THREADS;                                  \
+  BENCHMARK(BM_Find<Payload<N, Key>>)->Arg(100)->Arg(50)->Arg(0)->MR_BENCH_THREADS;            \
+  BENCHMARK(BM_Clear<Payload<N, Key>>)->Arg(1 << 10)->Arg(1 << 16);
+
+MR_BENCH_TYPE(16, std::string)
+MR_BENCH_TYPE(256, std::string)
+MR_BENCH_TYPE(4096, std::string)
+MR_BENCH_TYPE(16, InternedId)
+MR_BENCH_TYPE(256, InternedId)
+
+BENCHMARK(BM_CreateUnnamed<Payload<16, std::string>>)->MR_BENCH_THREADS;
+BENCHMARK(BM_CreateUnnamed<Payload<256, std::string>>)->MR_BENCH_THREADS;
+BENCHMARK(BM_Create<IterablePayload<16>>)->MR_BENCH_THREADS;
+BENCHMARK(BM_ForEach<IterablePayload<16>>);
+BENCHMARK(BM_ForEach<IterablePayload<256>>);
+BENCHMARK(BM_FindBatch<Payload<256, std::string>>)->Arg(8)->Arg(64);
+BENCHMARK(BM_FindLoop<Payload<256, std::string>>)->Arg(8)->Arg(64);
+
+BENCHMARK_MAIN();
@@ -1,6 +1,7 @@
 from conan import ConanFile
 from conan.tools.layout import basic_layout
 from conan.tools.build import check_min_cppstd
+from conan.tools.cmake import CMake, CMakeDeps, CMakeToolchain
 from conan.tools.files import copy
 
 class MrManager(ConanFile):
@@ -14,8 +15,11 @@ class MrManager(ConanFile):
     url = "https://github.com/4j-company/mr-manager"
 
     settings = "os", "compiler", "build_type", "arch"
+    # builds the mr-manager-bench target (MR_MANAGER_BUILD_BENCH) with conan build
+    options = {"with_bench": [True, False]}
+    default_options = {"with_bench": False}
 
-    exports_sources = "CMakeLists.txt", "include/*"
+    exports_sources = "CMakeLists.txt", "include/*", "bench/*"
 
     package_type = "header-library"
     implements = ["auto_header_only"]
@@ -28,10 +32,23 @@ class MrManager(ConanFile):
 
     def build_requirements(self):
         self.test_requires("gtest/1.14.0")
+        if self.options.with_bench:
+            self.test_requires("benchmark/1.8.3")
 
     def layout(self):
         basic_layout(self)
 
+    def generate(self):
+        toolchain = CMakeToolchain(self)
+        toolchain.cache_variables["MR_MANAGER_BUILD_BENCH"] = bool(self.options.with_bench)
+        toolchain.generate()
+        CMakeDeps(self).generate()
+
+    def build(self):
+        cmake = CMake(self)
+        cmake.configure()
+        cmake.build()
+
     def package(self):
         copy(self, "include/*", self.source_folder, self.package_folder)
 
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <typeindex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <folly/Executor.h>
+#include <folly/Try.h>
+#include <folly/executors/InlineExecutor.h>
+#include <folly/futures/Future.h>
+#include <folly/futures/SharedPromise.h>
+
+#include "manager.hpp"
+
+namespace mr {
+// Dependencies between entries of different Manager<T>s (a material on its textures, a mesh
+// on its materials), declared once and used to load and to erase them together.
+// load() runs the loaders of a root set and of everything it depends on in parallel, each
+// entry once and only after its dependencies; erase() and cascade() take dependents along
+// with an erased entry. The graph is built up front: add() and depend() must not overlap
+// load(), erase() or cascade(), and the graph must outlive the loads it started.
+// cascade() is opt-in through watch(), so an unwatched graph adds nothing to the write path
+// of its managers.
+class AssetGraph {
+public:
+  // one id of one Manager<T>, with the loader creating its entry
+  class Node {
+  public:
+    Node(const Node &) = delete;
+    Node & operator=(const Node &) = delete;
+
+    std::span<Node *const> dependencies() const noexcept {
+      return _dependencies;
+    }
+
+    std::span<Node *const> dependents() const noexcept {
+      return _dependents;
+    }
+
+  private:
+    friend AssetGraph;
+
+    Node() noexcept = default;
+
+    // creates the entry from the loader's result unless it exists already, sharing the load
+    // with concurrent loads of the same id
+    std::function<folly::SemiFuture<folly::Unit>()> _load;
+    // erases the entry, returns the number of erased entries
+    std::function<std::size_t()> _erase;
+    std::vector<Node *> _dependencies;
+    std::vector<Node *> _dependents;
+  };
+
+  AssetGraph() = default;
+  AssetGraph(const AssetGraph &) = delete;
+  AssetGraph & operator=(const AssetGraph &) = delete;
+
+  // the node of 'id', added with 'loader' (called as by Manager<T>::create_async()) unless
+  // the id has one already, whose loader is kept
+  template <typename T, typename Loader>
+    requires std::is_constructible_v<T, std::invoke_result_t<Loader &>>
+  Node & add(const asset_id_t<T> &id, Loader loader) {
+    std::lock_guard lock {_mutex};
+    auto &nodes = _nodes<T>().nodes;
+    auto [it, inserted] = nodes.try_emplace(id, nullptr);
+    if (inserted) {
+      Node &node = *_all.emplace_back(new Node);
+      // the loader runs inline in the task of the load() which gets to it first
+      node._load = [id, loader = std::move(loader)]() mutable {
+        return Manager<T>::get()
+          .find_or_create_async(id, loader, folly::getKeepAliveToken(folly::InlineExecutor::instance()))
+          .deferValue([](typename Manager<T>::Handle) { return folly::unit; });
+      };
+      node._erase = [id]() noexcept {
+        return Manager<T>::get().erase(id);
+      };
+      it->second = &node;
+    }
+    return *it->second;
+  }
+
+  template <typename T>
+  Node * find(const asset_id_t<T> &id) const {
+    std::lock_guard lock {_mutex};
+    auto types = _types.find(typeid(T));
+    if (types == _types.end()) {
+      return nullptr;
+    }
+    auto &nodes = static_cast<TypeNodes<T> &>(*types->second).nodes;
+    auto it = nodes.find(id);
+    return it == nodes.end() ? nullptr : it->second;
+  }
+
+  // 'dependent' is loaded after 'dependency', and erased with it;
+  // throws std::invalid_argument if that would close a cycle
+  void depend(Node &dependent, Node &dependency) {
+    std::lock_guard lock {_mutex};
+    if (_reaches(dependency, dependent)) {
+      throw std::invalid_argument("mr::AssetGraph: dependency cycle");
+    }
+    if (std::ranges::find(dependent._dependencies, &dependency) == dependent._dependencies.end()) {
+      dependent._dependencies.push_back(&dependency);
+      dependency._dependents.push_back(&dependent);
+    }
+  }
+
+  // loads the roots and their dependencies on 'executor', each entry once and after all of its
+  // dependencies, skipping entries which exist already. Concurrent load() calls sharing an entry
+  // share its loader call too. The future fails with the exception of the first failed loader;
+  // entries depending on a failed one aren't loaded.
+  folly::SemiFuture<folly::Unit> load(std::span<Node *const> roots, folly::Executor::KeepAlive<> executor) {
+    auto run = std::make_shared<Run>();
+    run->executor = std::move(executor);
+    std::vector<Node *> stack {roots.begin(), roots.end()};
+    while (!stack.empty()) {
+      Node *node = stack.back();
+      stack.pop_back();
+      if (run->states.try_emplace(node).second) {
+        stack.insert(stack.end(), node->_dependencies.begin(), node->_dependencies.end());
+      }
+    }
+
+    std::vector<Node *> ready;
+    for (auto &[node, state] : run->states) {
+      state.pending.store(node->_dependencies.size(), std::memory_order_relaxed);
+      if (node->_dependencies.empty()) {
+        ready.push_back(node);
+      }
+    }
+    run->remaining.store(run->states.size(), std::memory_order_relaxed);
+    folly::SemiFuture<folly::Unit> future = run->done.getSemiFuture();
+    if (run->states.empty()) {
+      run->done.setTry(folly::Try<folly::Unit> {folly::unit});
+    }
+    for (Node *node : ready) {
+      _start(run, node);
+    }
+    return future;
+  }
+
+  folly::SemiFuture<folly::Unit> load(Node &root, folly::Executor::KeepAlive<> executor) {
+    Node *roots[] = {&root};
+    return load(roots, std::move(executor));
+  }
+
+  // erases the entry of 'id' and, transitively, the entries depending on it;
+  // returns the number of erased entries
+  template <typename T>
+  std::size_t erase(const asset_id_t<T> &id) {
+    std::size_t erased = Manager<T>::get().erase(id);
+    if (Node *node = find<T>(id)) {
+      Node *removed[] = {node};
+      erased += _erase_dependents(removed);
+    }
+    return erased;
+  }
+
+  // starts recording the changes to every type the graph has nodes of (now or later) for
+  // cascade(). Each of these Manager<T>s then queues every write until the next cascade(),
+  // so a watched graph should be cascaded regularly (e.g. once per frame).
+  void watch() {
+    std::lock_guard lock {_mutex};
+    _watching = true;
+    for (auto &[type, nodes] : _types) {
+      nodes->watch(true);
+    }
+  }
+
+  // stops recording changes and drops the ones not cascaded yet
+  void unwatch() {
+    std::lock_guard lock {_mutex};
+    _watching = false;
+    for (auto &[type, nodes] : _types) {
+      nodes->watch(false);
+    }
+  }
+
+  // erases the dependents of the entries which were removed (erased, evicted or cleared)
+  // from their Manager<T> since the previous call, or since watch() for the first one;
+  // returns the number of erased entries. Removals made while the graph isn't watched are missed.
+  std::size_t cascade() {
+    std::vector<Node *> removed;
+    {
+      std::lock_guard lock {_mutex};
+      for (auto &[type, nodes] : _types) {
+        nodes->removed(removed);
+      }
+    }
+    return _erase_dependents(removed);
+  }
+
+private:
+  struct Nodes {
+    virtual ~Nodes() = default;
+    virtual void watch(bool watching) = 0;
+    // appends the nodes whose entries were removed since the last call and are still absent
+    virtual void removed(std::vector<Node *> &out) = 0;
+  };
+
+  template <typename T>
+  struct TypeNodes final : Nodes {
+    void watch(bool watching) override {
+      if (!watching) {
+        changes.reset();
+      } else if (changes == nullptr) {
+        changes.reset(new auto(Manager<T>::get().subscribe()));
+      }
+    }
+
+    void removed(std::vector<Node *> &out) override {
+      if (changes == nullptr) {
+        return;
+      }
+      changes->drain([&](const typename Manager<T>::Change &change) {
+        if (change.version == 0 && !Manager<T>::get().find(change.id)) {
+          if (auto it = nodes.find(change.id); it != nodes.end()) {
+            out.push_back(it->second);
+          }
+        }
+      });
+    }
+
+    std::unordered_map<asset_id_t<T>, Node *, asset_hash_t<T>, asset_key_equal_t<T>> nodes;
+    // only while the graph is watched
+    std::unique_ptr<typename Manager<T>::ChangeQueue> changes;
+  };
+
+  // one load(): the dependencies each node still waits for, shared by the tasks running it
+  struct Run {
+    struct State {
+      std::atomic<std::size_t> pending {0};
+      // a dependency failed, so the node is only completed, not loaded
+      std::atomic<bool> failed {false};
+    };
+
+    folly::Executor::KeepAlive<> executor;
+    // filled before the first task starts and only read afterwards
+    std::unordered_map<Node *, State> states;
+    std::atomic<std::size_t> remaining {0};
+    std::mutex error_mutex;
+    std::optional<folly::Try<folly::Unit>> error;
+    folly::SharedPromise<folly::Unit> done;
+  };
+
+  template <typename T>
+  TypeNodes<T> & _nodes() {
+    auto &nodes = _types[typeid(T)];
+    if (nodes == nullptr) {
+      nodes = std::make_unique<TypeNodes<T>>();
+      nodes->watch(_watching);
+    }
+    return static_cast<TypeNodes<T> &>(*nodes);
+  }
+
+  // whether 'to' is 'from' or one of its (transitive) dependencies
+  static bool _reaches(Node &from, Node &to) {
+    std::vector<Node *> stack {&from};
+    std::unordered_set<Node *> seen;
+    while (!stack.empty()) {
+      Node *node = stack.back();
+      stack.pop_back();
+      if (node == &to) {
+        return true;
+      }
+      if (seen.insert(node).second) {
+        stack.insert(stack.end(), node->_dependencies.begin(), node->_dependencies.end());
+      }
+    }
+    return false;
+  }
+
+  static void _start(const std::shared_ptr<Run> &run, Node *node) {
+    run->executor->add([run, node] {
+      if (run->states.at(node).failed.load(std::memory_order_acquire)) {
+        _finish(run, node, folly::Try<folly::Unit> {folly::unit});
+        return;
+      }
+      // completes right away unless another load() or create_async() is loading the entry
+      folly::futures::detachOn(run->executor, folly::makeSemiFutureWith([node] {
+        return node->_load();
+      }).deferTry([run, node](folly::Try<folly::Unit> &&result) {
+        _finish(run, node, std::move(result));
+      }));
+    });
+  }
+
+  static void _finish(const std::shared_ptr<Run> &run, Node *node, folly::Try<folly::Unit> &&result) {
+    bool failed = result.hasException() || run->states.at(node).failed.load(std::memory_order_acquire);
+    if (result.hasException()) {
+      std::lock_guard lock {run->error_mutex};
+      if (!run->error) {
+        run->error.emplace(std::move(result));
+      }
+    }
+    for (Node *dependent : node->_dependents) {
+      auto it = run->states.find(dependent);
+      if (it == run->states.end()) {
+        continue;
+      }
+      if (failed) {
+        it->second.failed.store(true, std::memory_order_release);
+      }
+      if (it->second.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        _start(run, dependent);
+      }
+    }
+    if (run->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      run->done.setTry(run->error ? std::move(*run->error) : folly::Try<folly::Unit> {folly::unit});
+    }
+  }
+
+  // erases the entries depending, directly or not, on the given nodes; each one once
+  static std::size_t _erase_dependents(std::span<Node *const> removed) {
+    std::size_t erased = 0;
+    std::vector<Node *> stack;
+    std::unordered_set<Node *> seen;
+    for (Node *node : removed) {
+      stack.insert(stack.end(), node->_dependents.begin(), node->_dependents.end());
+    }
+    while (!stack.empty()) {
+      Node *node = stack.back();
+      stack.pop_back();
+      if (seen.insert(node).second) {
+        erased += node->_erase();
+        stack.insert(stack.end(), node->_dependents.begin(), node->_dependents.end());
+      }
+    }
+    return erased;
+  }
+
+  mutable std::mutex _mutex;
+  std::vector<std::unique_ptr<Node>> _all;
+  std::unordered_map<std::type_index, std::unique_ptr<Nodes>> _types;
+  bool _watching = false;
+};
+
+} // namespace mr
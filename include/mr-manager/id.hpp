@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <folly/concurrency/ConcurrentHashMap.h>
+
+namespace mr {
+// 64-bit FNV-1a; the same function hashes runtime strings and compile-time literals
+constexpr std::uint64_t hash_id(std::string_view str) noexcept {
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+  for (char c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// string literal together with its hash, computed at compile time
+// a structural type, so literal ids can be template arguments
+template <std::size_t N>
+struct LiteralId {
+  char str[N] {};
+  std::uint64_t hash = 0;
+
+  consteval LiteralId(const char (&literal)[N]) noexcept {
+    for (std::size_t i = 0; i < N; i++) {
+      str[i] = literal[i];
+    }
+    hash = hash_id(view());
+  }
+
+  constexpr std::string_view view() const noexcept {
+    return {str, N - 1};
+  }
+};
+
+// non-owning id with a precomputed hash, used to probe without rehashing
+struct HashedId {
+  std::string_view str;
+  std::uint64_t hash;
+
+  constexpr HashedId(std::string_view s) noexcept : str(s), hash(hash_id(s)) {}
+  constexpr HashedId(std::string_view s, std::uint64_t h) noexcept : str(s), hash(h) {}
+
+  constexpr bool operator==(const HashedId &other) const noexcept {
+    return hash == other.hash && str == other.str;
+  }
+};
+
+namespace detail {
+struct InternedString {
+  std::uint64_t hash;
+  std::string str;
+};
+
+struct HashedIdHash {
+  std::size_t operator()(const HashedId &id) const noexcept {
+    return id.hash;
+  }
+};
+
+// process-wide and never shrinks, so interned strings are immortal
+class InternPool {
+public:
+  static InternPool & get() noexcept {
+    static InternPool *pool = new InternPool;
+    return *pool;
+  }
+
+  const InternedString * intern(HashedId id) {
+    auto it = _strings.find(id);
+    if (it != _strings.end()) [[likely]] {
+      return it->second;
+    }
+    auto *fresh = new InternedString {id.hash, std::string(id.str)};
+    auto [inserted, success] = _strings.try_emplace(HashedId {fresh->str, fresh->hash}, fresh);
+    if (!success) {
+      delete fresh;
+    }
+    return inserted->second;
+  }
+
+  // the interned copy of 'id', or nullptr if it was never interned; adds nothing
+  const InternedString * lookup(HashedId id) const noexcept {
+    auto it = _strings.find(id);
+    return it == _strings.cend() ? nullptr : it->second;
+  }
+
+  std::size_t size() const noexcept {
+    return _strings.size();
+  }
+
+private:
+  InternPool() = default;
+
+  folly::ConcurrentHashMap<HashedId, const InternedString *, HashedIdHash> _strings;
+};
+} // namespace detail
+
+// id interned in a process-wide pool: it is one pointer, hashing returns the
+// precomputed hash and equality is a pointer compare. Plug it in with
+//   template <> struct mr::AssetId<Texture> { using type = mr::InternedId; };
+class InternedId {
+public:
+  InternedId() noexcept = default;
+  InternedId(HashedId id) : _string(id.str.empty() ? nullptr : detail::InternPool::get().intern(id)) {}
+  InternedId(std::string_view str) : InternedId(HashedId {str}) {}
+  InternedId(const std::string &str) : InternedId(HashedId {str}) {}
+  InternedId(const char *str) : InternedId(HashedId {str}) {}
+
+  // the id of a string interned already, without interning it otherwise, so that probing
+  // with strings from untrusted input doesn't grow the pool
+  static std::optional<InternedId> lookup(HashedId id) noexcept {
+    if (id.str.empty()) {
+      return InternedId {};
+    }
+    const detail::InternedString *string = detail::InternPool::get().lookup(id);
+    if (string == nullptr) {
+      return std::nullopt;
+    }
+    InternedId result;
+    result._string = string;
+    return result;
+  }
+
+  std::string_view str() const noexcept {
+    return _string == nullptr ? std::string_view {} : std::string_view {_string->str};
+  }
+
+  std::uint64_t hash() const noexcept {
+    return _string == nullptr ? hash_id({}) : _string->hash;
+  }
+
+  bool operator==(const InternedId &other) const noexcept = default;
+
+private:
+  const detail::InternedString *_string = nullptr;
+};
+
+// type of "..."_id literals: hashed at compile time and interned at most once per literal
+template <LiteralId S>
+struct StaticId {
+  static inline constexpr std::string_view str = S.view();
+  static inline constexpr std::uint64_t hash = S.hash;
+
+  constexpr operator std::string_view() const noexcept {
+    return str;
+  }
+
+  constexpr operator HashedId() const noexcept {
+    return {str, hash};
+  }
+
+  operator InternedId() const {
+    static const InternedId id {HashedId {str, hash}};
+    return id;
+  }
+};
+
+// fixed set of ids known at build time, e.g. mr::StaticAssets<"shaders/basic", "shaders/pbr">.
+// The position of a literal is resolved at compile time; runtime ids are mapped to positions
+// through a collision-free table of their hashes, also built at compile time.
+template <LiteralId ...Ids>
+struct StaticAssets {
+  static inline constexpr std::size_t size = sizeof...(Ids);
+
+  // position of StaticId<S>, or size if S isn't in the set
+  template <LiteralId S>
+  static inline constexpr std::size_t index_of = [] {
+    std::size_t i = 0;
+    (void)((std::is_same_v<StaticId<S>, StaticId<Ids>> || (++i, false)) || ...);
+    return i;
+  }();
+
+  // position of a runtime id, or size: one table load and one compare
+  static constexpr std::size_t find(HashedId id) noexcept {
+    std::uint32_t slot = _table[(id.hash >> _layout.shift) & _layout.mask];
+    if (slot == 0 || _hashes[slot - 1] != id.hash || _strs[slot - 1] != id.str) {
+      return size;
+    }
+    return slot - 1;
+  }
+
+private:
+  struct Layout {
+    unsigned shift;
+    std::size_t mask;
+  };
+
+  static inline constexpr std::array<std::uint64_t, size> _hashes {Ids.hash...};
+  static inline constexpr std::array<std::string_view, size> _strs {StaticId<Ids>::str...};
+
+  // the smallest power-of-two table, and the hash bits indexing it, without collisions
+  static consteval Layout _find_layout() {
+    for (std::size_t slots = std::bit_ceil(std::max<std::size_t>(size, 1)); slots <= (std::size_t{1} << 20); slots *= 2) {
+      for (unsigned shift = 0; shift < 64; shift++) {
+        Layout layout {shift, slots - 1};
+        bool distinct = true;
+        for (std::size_t i = 0; i < size && distinct; i++) {
+          for (std::size_t j = i + 1; j < size && distinct; j++) {
+            distinct = ((_hashes[i] >> shift) & layout.mask) != ((_hashes[j] >> shift) & layout.mask);
+          }
+        }
+        if (distinct) {
+          return layout;
+        }
+      }
+    }
+    throw std::logic_error("mr::StaticAssets: duplicate ids");
+  }
+
+  static inline constexpr Layout _layout = _find_layout();
+
+  // position + 1 of the id owning each slot, 0 for none
+  static inline constexpr std::array<std::uint32_t, _layout.mask + 1> _table = [] {
+    std::array<std::uint32_t, _layout.mask + 1> table {};
+    for (std::size_t i = 0; i < size; i++) {
+      table[(_hashes[i] >> _layout.shift) & _layout.mask] = static_cast<std::uint32_t>(i + 1);
+    }
+    return table;
+  }();
+};
+
+namespace literals {
+template <LiteralId S>
+consteval StaticId<S> operator""_id() noexcept {
+  return {};
+}
+} // namespace literals
+} // namespace mr
+
+template <>
+struct std::hash<mr::InternedId> {
+  std::size_t operator()(const mr::InternedId &id) const noexcept {
+    return id.hash();
+  }
+};
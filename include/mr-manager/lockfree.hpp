@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+namespace mr::detail {
+inline constexpr std::uint32_t invalid_index = ~std::uint32_t{0};
+
+// Append-only array of default constructed E stored in segments of doubling
+// size. Segments are allocated on first use and never moved, so references
+// stay valid and lookups never take a lock.
+template <typename E, std::size_t FirstSegmentBits = 6>
+struct SegmentedArray {
+  constexpr SegmentedArray() noexcept = default;
+  constexpr ~SegmentedArray() noexcept {
+    for (auto &segment : _segments) {
+      delete[] segment.exchange(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  SegmentedArray(const SegmentedArray &) = delete;
+  SegmentedArray & operator=(const SegmentedArray &) = delete;
+
+  // nullptr if the segment holding 'index' was never allocated
+  constexpr const E * find(std::uint32_t index) const noexcept {
+    std::size_t segment = _segment_of(index);
+    if (segment >= _max_segments) [[unlikely]] {
+      return nullptr;
+    }
+    const E *elements = _segments[segment].load(std::memory_order_acquire);
+    return elements == nullptr ? nullptr : elements + (index - _segment_begin(segment));
+  }
+  constexpr E * find(std::uint32_t index) noexcept {
+    return const_cast<E *>(std::as_const(*this).find(index));
+  }
+
+  // allocates the segment holding 'index' on demand
+  constexpr E & ensure(std::uint32_t index) noexcept {
+    std::size_t segment = _segment_of(index);
+    E *elements = _segments[segment].load(std::memory_order_acquire);
+    if (elements == nullptr) [[unlikely]] {
+      E *fresh = new E[_segment_size(segment)];
+      if (_segments[segment].compare_exchange_strong(elements, fresh, std::memory_order_acq_rel)) {
+        elements = fresh;
+      } else {
+        delete[] fresh;
+      }
+    }
+    return elements[index - _segment_begin(segment)];
+  }
+
+private:
+  static inline constexpr std::size_t _max_segments = 32 - FirstSegmentBits + 1;
+
+  static constexpr std::size_t _segment_of(std::uint32_t index) noexcept {
+    return std::bit_width(index >> FirstSegmentBits);
+  }
+  static constexpr std::size_t _segment_begin(std::size_t segment) noexcept {
+    return segment == 0 ? 0 : std::size_t{1} << (FirstSegmentBits + segment - 1);
+  }
+  static constexpr std::size_t _segment_size(std::size_t segment) noexcept {
+    return std::size_t{1} << (FirstSegmentBits + (segment == 0 ? 0 : segment - 1));
+  }
+
+  std::array<std::atomic<E *>, _max_segments> _segments {};
+};
+
+// Treiber stack of indices. Elements keep their own 'next' link (returned by
+// the 'next' callable); the head is packed as [tag:32 | index:32] so an index
+// that is popped and pushed again between a load and a CAS can't cause ABA.
+struct IndexStack {
+  template <typename NextFn>
+  constexpr void push(std::uint32_t index, NextFn &&next) noexcept {
+    std::atomic<std::uint32_t> &link = next(index);
+    std::uint64_t head = _head.load(std::memory_order_relaxed);
+    do {
+      link.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+    } while (!_head.compare_exchange_weak(head, _pack(index, (head >> 32) + 1),
+                                          std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  // returns invalid_index when empty
+  template <typename NextFn>
+  constexpr std::uint32_t pop(NextFn &&next) noexcept {
+    std::uint64_t head = _head.load(std::memory_order_acquire);
+    while (static_cast<std::uint32_t>(head) != invalid_index) {
+      std::uint32_t index = static_cast<std::uint32_t>(head);
+      std::uint32_t following = next(index).load(std::memory_order_relaxed);
+      if (_head.compare_exchange_weak(head, _pack(following, (head >> 32) + 1),
+                                      std::memory_order_acquire, std::memory_order_acquire)) {
+        return index;
+      }
+    }
+    return invalid_index;
+  }
+
+private:
+  static constexpr std::uint64_t _pack(std::uint32_t index, std::uint32_t tag) noexcept {
+    return (std::uint64_t{tag} << 32) | index;
+  }
+
+  std::atomic<std::uint64_t> _head {_pack(invalid_index, 0)};
+};
+
+} // namespace mr::detail
@@ -1,55 +1,456 @@
 #pragma once
 
 #include <memory_resource>
+#include <algorithm>
 #include <cassert>
+#include <array>
 #include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <tuple>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include <folly/Executor.h>
+#include <folly/Try.h>
 #include <folly/concurrency/ConcurrentHashMap.h>
+#include <folly/experimental/coro/Coroutine.h>
+#include <folly/futures/Future.h>
+#include <folly/futures/SharedPromise.h>
+#include <folly/synchronization/Rcu.h>
+
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Task.h>
+#include <folly/experimental/coro/Traits.h>
+#endif
+
+#include "id.hpp"
+#include "persist.hpp"
+#include "pool.hpp"
+#include "reclaim.hpp"
+#include "registry.hpp"
+#include "slot_table.hpp"
+#include "snapshot.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 
 namespace mr {
 struct UnnamedTag {};
 constexpr inline UnnamedTag unnamed;
 
-template <typename> struct AssetId { using type = std::string; };
+// transparent hasher and equality for string ids: std::string, std::string_view
+// and const char * hash and compare alike
+struct StringHash {
+  using is_transparent = void;
+
+  size_t operator()(std::string_view str) const noexcept {
+    return std::hash<std::string_view>{}(str);
+  }
+};
+struct StringEqual {
+  using is_transparent = void;
+
+  bool operator()(std::string_view lhs, std::string_view rhs) const noexcept {
+    return lhs == rhs;
+  }
+};
+
+// AssetId<T> may also provide 'hash' and 'key_equal' for the id type,
+// std::hash and std::equal_to are used otherwise
+template <typename> struct AssetId {
+  using type = std::string;
+  using hash = StringHash;
+  using key_equal = StringEqual;
+};
 template <typename T> using asset_id_t = typename AssetId<T>::type;
 
+namespace detail {
+template <typename Id> struct id_hash { using type = std::hash<typename Id::type>; };
+template <typename Id> requires requires { typename Id::hash; }
+struct id_hash<Id> { using type = typename Id::hash; };
+
+template <typename Id> struct id_equal { using type = std::equal_to<typename Id::type>; };
+template <typename Id> requires requires { typename Id::key_equal; }
+struct id_equal<Id> { using type = typename Id::key_equal; };
+} // namespace detail
+
+template <typename T> using asset_hash_t = typename detail::id_hash<AssetId<T>>::type;
+template <typename T> using asset_key_equal_t = typename detail::id_equal<AssetId<T>>::type;
+
+// per-type pool configuration; specialize AssetPool<T> deriving from DefaultAssetPool
+struct DefaultAssetPool {
+  // objects in the first arena (requested on first create)
+  static inline constexpr std::size_t initial_capacity = 1024;
+
+  // objects in the next arena given the capacity of the last one
+  static constexpr std::size_t grow(std::size_t capacity) noexcept {
+    return capacity * 2;
+  }
+
+  // alignment of each object's block, 0 for the object's own. The stride between objects is
+  // rounded up to it, so mr::cache_line keeps objects written by different threads from
+  // sharing a cache line, and 2 * mr::cache_line also keeps them off adjacent-line prefetches
+  static inline constexpr std::size_t block_align = 0;
+
+  static std::pmr::memory_resource * upstream() noexcept {
+    return std::pmr::new_delete_resource();
+  }
+
+  // resource objects are allocated from, constructed from the type's SlabResource *
+  template <typename T> using resource = MagazineResource<T>;
+};
+template <typename> struct AssetPool : DefaultAssetPool {};
+
+enum class Reclamation {
+  // objects are destroyed as soon as the hash map reclaims their entry
+  automatic,
+  // objects are retired to per-thread batches and destroyed by Manager<T>::collect()
+  deferred,
+};
+
+// per-type behaviour; specialize AssetPolicy<T> deriving from DefaultAssetPolicy
+struct DefaultAssetPolicy {
+  static inline constexpr Reclamation reclamation = Reclamation::automatic;
+  // objects are reference counted and can be held through Manager<T>::SharedHandle
+  static inline constexpr bool shared = false;
+
+  // find_snapshot() reads an immutable copy of the table, rebuilt by publish(), for types
+  // which are read far more often than written
+  static inline constexpr bool snapshot = false;
+
+  // upper bound on the summed cost() of named entries, 0 for unbounded. Over it, creating
+  // an entry evicts others (as by erase()) with a CLOCK sweep which skips recently found
+  // entries and entries held by a SharedHandle
+  static inline constexpr std::size_t budget = 0;
+
+  // e.g. the decoded size in bytes for a byte budget
+  template <typename T>
+  static constexpr std::size_t cost(const T &) noexcept {
+    return 1;
+  }
+
+  // ids known at build time, e.g. mr::StaticAssets<"shaders/basic">: their entries are also
+  // kept in slots of their own, which find_static() reads without hashing
+  using static_assets = StaticAssets<>;
+
+  // slots of the per-thread cache find_cached() goes through, a power of two (0 disables it)
+  static inline constexpr std::size_t lookup_cache = 0;
+
+  // named entries carry a version from a per-type sequence, so Handle::version() is available
+  // and subscribers see which entry a change made. That is one shared atomic increment per
+  // named create; otherwise every entry has version 1. Types with a codec are always versioned
+  static inline constexpr bool versioned = false;
+
+  // named entries also take a slot of a dense table, so Handle::compact() is available.
+  // That adds shared atomics to every named create and destroy
+  static inline constexpr bool compact_handles = false;
+
+  // every create and destroy marks its block in the pool's liveness bitmap, so for_each()
+  // and parallel_for_each() are available. That is one shared atomic per create and destroy
+  static inline constexpr bool iterable = false;
+
+  // codec of the cold tier, void for none. With one, Manager<T>::cool() encodes named entries
+  // not found since its previous call into side storage and destroys their objects; find()
+  // decodes them back into the pool. A codec provides
+  //   static void encode(const T &, std::vector<std::byte> &out);
+  //   static T decode(std::span<const std::byte>);
+  // and may compress, or spill to a file and keep only an offset.
+  using codec = void;
+};
+template <typename> struct AssetPolicy : DefaultAssetPolicy {};
+
+using UnnamedId = SlotId;
+
 template <typename T> struct Manager;
 
+namespace detail {
+// objects are built with T{args...}, as create() always did, so that e.g. a vector gets the
+// arguments as its elements; with T(args...) only for arguments braces can't take
+template <typename T, typename ...Args>
+concept brace_constructible = requires (Args && ...args) { T{std::forward<Args>(args)...}; };
+
+template <typename T, typename ...Args>
+T * construct_at(void *memory, Args && ...args) {
+  if constexpr (brace_constructible<T, Args...>) {
+    return new (memory) T{std::forward<Args>(args)...};
+  } else {
+    return new (memory) T(std::forward<Args>(args)...);
+  }
+}
+
+// where a shared object is stored, for the eviction on the release of its last SharedHandle:
+// the id of a named one or the slot of an unnamed one
+template <typename Id, bool Shared> struct BlockKey {};
+template <typename Id> struct BlockKey<Id, true> {
+  std::optional<Id> id;
+  SlotId unnamed;
+};
+
+// bookkeeping kept in the pool block after the object, empty unless the policy opts in
+template <typename Id, bool Enabled, bool Shared> struct BlockState {};
+template <typename Id, bool Shared> struct BlockState<Id, true, Shared> : BlockKey<Id, Shared> {
+  // one reference for the table entry (or unnamed slot) plus one per SharedHandle
+  std::atomic<std::uint32_t> refs {1};
+  std::atomic<bool> evictable {false};
+  // CLOCK bit, set by lookups and cleared by the budget sweep
+  std::atomic<bool> referenced {true};
+  std::size_t cost = 0;
+  // set by the sweep, which already took the cost off the total
+  bool evicted = false;
+};
+
+// position of an entry's id in AssetPolicy<T>::static_assets, kept only if there are any
+template <bool Enabled> struct StaticIndex {};
+template <> struct StaticIndex<true> {
+  std::size_t value = 0;
+};
+} // namespace detail
+
 template <typename T>
 struct Manager {
-  static inline constexpr size_t _max_elements = 1024;
-  static inline constexpr size_t _buffer_size = sizeof(T) * _max_elements;
+  using PoolT = AssetPool<T>;
+  using PolicyT = AssetPolicy<T>;
+  using AssetIdT = asset_id_t<T>;
+  using StaticAssetsT = typename PolicyT::static_assets;
+  using CodecT = typename PolicyT::codec;
+
+  static_assert(!(PolicyT::shared && PolicyT::snapshot), "shared handles can't be combined with snapshots yet");
+  static_assert(PolicyT::lookup_cache == 0 || std::has_single_bit(PolicyT::lookup_cache), "the lookup cache size must be a power of two");
+  static_assert(StaticAssetsT::size == 0 || std::is_same_v<AssetIdT, InternedId> || std::is_convertible_v<const AssetIdT &, std::string_view>,
+                "static assets need string or interned ids");
+
+  // whether objects are reference counted, and whether pool blocks carry bookkeeping at all
+  static inline constexpr bool _counted = PolicyT::shared || PolicyT::snapshot;
+  static inline constexpr bool _cold = !std::is_void_v<CodecT>;
+  static inline constexpr bool _stateful = _counted || PolicyT::budget != 0 || _cold;
+  static inline constexpr bool _has_statics = StaticAssetsT::size != 0;
+  // the cold tier tells outdated copies apart by their version
+  static inline constexpr bool _versioned = PolicyT::versioned || _cold;
+  static inline constexpr bool _iterable = PolicyT::iterable;
+  // whether save_to() and load_from() are available
+  static inline constexpr bool _storable = std::is_trivially_copyable_v<T> && detail::is_storable_id_v<AssetIdT>;
+  // whether the table is probed with a K as is (folly's heterogeneous find): asset_hash_t<T>
+  // and asset_key_equal_t<T> are transparent and accept it, in either argument order
+  template <typename K>
+  static inline constexpr bool _transparent = !std::is_same_v<std::remove_cvref_t<K>, AssetIdT>
+    && requires (const K &id, const AssetIdT &key) {
+      typename asset_hash_t<T>::is_transparent;
+      typename asset_key_equal_t<T>::is_transparent;
+      asset_hash_t<T> {}(id);
+      asset_key_equal_t<T> {}(key, id);
+      asset_key_equal_t<T> {}(id, key);
+    };
+
+  // pool block: the object comes first, so a T * from the pool is also its Block *
+  struct Block {
+    T value;
+    [[no_unique_address]] detail::BlockState<AssetIdT, _stateful, PolicyT::shared> state;
+
+    // built as by detail::construct_at()
+    template <typename ...Args> requires detail::brace_constructible<T, Args...>
+    Block(std::in_place_t, Args && ...args) noexcept : value{std::forward<Args>(args)...} {}
 
-  static inline std::array<std::byte, _buffer_size> _memory_buffer {};
-  static inline std::pmr::monotonic_buffer_resource _memory_resource {_memory_buffer.data(), _buffer_size};
-  static inline std::pmr::synchronized_pool_resource _memory_pool_resource {&_memory_resource};
-  static inline std::pmr::polymorphic_allocator<T> _allocator {&_memory_pool_resource};
+    template <typename ...Args>
+    Block(std::in_place_t, Args && ...args) noexcept : value(std::forward<Args>(args)...) {}
+  };
+
+  static inline constexpr size_t _block_align = std::max(alignof(Block), PoolT::block_align);
+  static_assert(std::has_single_bit(_block_align), "the block alignment must be a power of two");
+
+  static inline SlabResource _memory_resource {sizeof(Block), _block_align, PoolT::initial_capacity, &PoolT::grow, PoolT::upstream()};
+  static inline typename PoolT::template resource<T> _memory_pool_resource {&_memory_resource};
+  static inline std::pmr::polymorphic_allocator<Block> _allocator {&_memory_pool_resource};
 
   struct Entry {
     T* ptr = nullptr;
+    [[no_unique_address]] std::conditional_t<PolicyT::compact_handles, SlotId, std::tuple<>> slot;
+    // taken from a per-type sequence if _versioned, so a later entry for an id has a larger version
+    std::uint64_t version = 0;
+    [[no_unique_address]] detail::StaticIndex<_has_statics> static_index;
 
+    // constructs T directly in pool storage
     template <typename ...Ts>
-    Entry(Ts && ...args) noexcept
-    : ptr(_allocator.allocate(1))
+    Entry(const AssetIdT &id, std::in_place_t, Ts && ...args) noexcept
+    : Entry(id, _construct(std::forward<Ts>(args)...))
+    {}
+
+    // takes over an object already in a pool block
+    Entry([[maybe_unused]] const AssetIdT &id, T *object) noexcept
+    : ptr(object)
+    , slot(_insert_named(ptr))
+    , version(_next_version())
     {
-      assert(ptr != nullptr);
-      new (ptr) T(std::forward<Ts>(args)...);
+      if constexpr (_has_statics) {
+        static_index.value = StaticAssetsT::find(_hashed(id));
+      }
+      if constexpr (PolicyT::shared) {
+        _block(ptr)->state.id.emplace(id);
+      }
+      if constexpr (PolicyT::budget != 0) {
+        _block(ptr)->state.cost = PolicyT::cost(std::as_const(*ptr));
+        _cost.fetch_add(_block(ptr)->state.cost, std::memory_order_relaxed);
+      }
     }
     ~Entry() noexcept {
-      ptr->~T();
-      Manager<T>::_allocator.deallocate(ptr, 1);
+      if (ptr != nullptr) {
+        MR_MANAGER_TRACE(reclaim, std::string_view {});
+        if constexpr (PolicyT::budget != 0) {
+          if (!_block(ptr)->state.evicted) {
+            _cost.fetch_sub(_block(ptr)->state.cost, std::memory_order_relaxed);
+          }
+        }
+        _unlink_static(*this);
+        if constexpr (PolicyT::compact_handles) {
+          _named.erase(slot);
+        }
+        _drop(ptr);
+      }
     }
 
     Entry() = default;
     Entry(const Entry &other) noexcept = delete;
     Entry & operator=(const Entry &other) noexcept = delete;
-    Entry(Entry &&other) noexcept = default;
-    Entry & operator=(Entry &&other) noexcept = default;
+    Entry(Entry &&other) noexcept
+    : ptr(std::exchange(other.ptr, nullptr))
+    , slot(other.slot)
+    , version(other.version)
+    , static_index(other.static_index)
+    {}
+    Entry & operator=(Entry &&other) noexcept {
+      std::swap(ptr, other.ptr);
+      std::swap(slot, other.slot);
+      std::swap(version, other.version);
+      std::swap(static_index, other.static_index);
+      return *this;
+    }
+
+    // entries are identified by the object they own
+    bool operator==(const Entry &other) const noexcept {
+      return ptr == other.ptr;
+    }
   };
 
-  using AssetIdT = asset_id_t<T>;
-  using HashMapT = folly::ConcurrentHashMap<AssetIdT, Entry>;
+  using HashMapT = folly::ConcurrentHashMap<AssetIdT, Entry, asset_hash_t<T>, asset_key_equal_t<T>>;
+  using LoadT = folly::SharedPromise<folly::Unit>;
+  using SnapshotT = SnapshotTable<AssetIdT, T, asset_hash_t<T>, asset_key_equal_t<T>>;
+
+  // 8-byte handle which pins nothing: it is resolved through the dense slot arrays,
+  // never through the hash map. It resolves to nullptr once the object it was taken
+  // from has been destroyed (for named assets: once the replaced or erased entry is reclaimed).
+  // Like UnnamedHandle, the resolved pointer must not outlive a concurrent erase unless
+  // reclamation is deferred and collect() runs at a quiescent point.
+  struct CompactHandle {
+    static inline constexpr std::uint32_t named_bit = std::uint32_t{1} << 31;
+
+    T* get() const noexcept {
+      return _resolve(slot);
+    }
+
+    T* operator->() const noexcept {
+      return get();
+    }
+
+    T& value() const noexcept {
+      return *get();
+    }
+
+    explicit operator bool() const noexcept {
+      return get() != nullptr;
+    }
+
+    bool operator==(const CompactHandle &) const noexcept = default;
+
+    SlotId slot;
+  };
+
+  // object found in the snapshot; keeps an RCU read section open, so it should be short-lived
+  struct SnapshotHandle {
+    const T* operator->() const noexcept {
+      return ptr;
+    }
+
+    const T& value() const noexcept {
+      return *ptr;
+    }
+
+    folly::rcu_reader guard;
+    const T* ptr;
+  };
+
+  // counted reference to an object of a type whose AssetPolicy<T>::shared is set.
+  // The object lives as long as its entry or any SharedHandle to it; once the last
+  // SharedHandle to an evictable object is released, its entry is erased as by erase().
+  struct SharedHandle {
+    SharedHandle() noexcept = default;
+    SharedHandle(const SharedHandle &other) noexcept
+    : _ptr(other._ptr)
+    {
+      if (_ptr != nullptr) {
+        _block(_ptr)->state.refs.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    SharedHandle(SharedHandle &&other) noexcept
+    : _ptr(std::exchange(other._ptr, nullptr))
+    {}
+    SharedHandle & operator=(SharedHandle other) noexcept {
+      std::swap(_ptr, other._ptr);
+      return *this;
+    }
+    ~SharedHandle() noexcept {
+      if (_ptr != nullptr) {
+        _unshare(_ptr);
+      }
+    }
+
+    T* get() const noexcept {
+      return _ptr;
+    }
+
+    T* operator->() const noexcept {
+      return _ptr;
+    }
+
+    T& value() const noexcept {
+      return *_ptr;
+    }
+
+    explicit operator bool() const noexcept {
+      return _ptr != nullptr;
+    }
+
+    // an evictable object leaves the table when no SharedHandle refers to it anymore
+    void set_evictable(bool evictable = true) const noexcept {
+      _block(_ptr)->state.evictable.store(evictable, std::memory_order_release);
+    }
+
+    bool operator==(const SharedHandle &) const noexcept = default;
+
+  private:
+    friend Manager;
+
+    explicit SharedHandle(T *ptr) noexcept
+    : _ptr(ptr)
+    {
+      _block(_ptr)->state.refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    T* _ptr = nullptr;
+  };
 
   struct Handle {
     T* operator->() noexcept {
@@ -64,50 +465,1287 @@ struct Manager {
       return *it->second.ptr;
     }
 
+    // compared with the version find() returns now, tells whether the entry was replaced since
+    std::uint64_t version() const noexcept requires _versioned {
+      return it->second.version;
+    }
+
+    CompactHandle compact() const noexcept requires PolicyT::compact_handles {
+      SlotId slot = it->second.slot;
+      return {{slot.index | CompactHandle::named_bit, slot.generation}};
+    }
+
+    SharedHandle share() const noexcept requires PolicyT::shared {
+      return SharedHandle{it->second.ptr};
+    }
+
     HashMapT::const_iterator it;
   };
 
+  // unnamed assets live in the slot table until clear(), which invalidates their handles
+  struct UnnamedHandle {
+    T* operator->() noexcept {
+      return ptr;
+    }
+
+    const T& value() const noexcept {
+      return *ptr;
+    }
+
+    T& value() noexcept {
+      return *ptr;
+    }
+
+    CompactHandle compact() const noexcept {
+      return {id};
+    }
+
+    SharedHandle share() const noexcept requires PolicyT::shared {
+      return SharedHandle{ptr};
+    }
+
+    UnnamedId id;
+    T* ptr;
+  };
+
+  // change to a named entry: the version of the new entry (1 unless the type is versioned),
+  // or 0 if the id was removed
+  struct Change {
+    AssetIdT id;
+    std::uint64_t version;
+  };
+
+  // queue of the changes made to named entries while it is alive, returned by subscribe().
+  // A change may already be outdated when it is drained, so consumers look the id up again.
+  // Nothing is dropped, so a queue which is never drained keeps growing.
+  class ChangeQueue {
+  public:
+    ~ChangeQueue() noexcept {
+      Manager &manager = get();
+      std::lock_guard lock {manager._subscribers_mutex};
+      std::erase(manager._subscribers, this);
+      manager._subscriber_count.store(manager._subscribers.size(), std::memory_order_relaxed);
+    }
+
+    ChangeQueue(const ChangeQueue &) = delete;
+    ChangeQueue & operator=(const ChangeQueue &) = delete;
+
+    // calls f(const Change &) for every change queued so far, oldest first; returns their number
+    template <typename F>
+    size_t drain(F &&f) {
+      std::vector<Change> batch;
+      {
+        std::lock_guard lock {_mutex};
+        batch.swap(_changes);
+      }
+      for (const Change &change : batch) {
+        f(change);
+      }
+      return batch.size();
+    }
+
+  private:
+    friend Manager;
+
+    ChangeQueue() {
+      Manager &manager = get();
+      std::lock_guard lock {manager._subscribers_mutex};
+      manager._subscribers.push_back(this);
+      manager._subscriber_count.store(manager._subscribers.size(), std::memory_order_relaxed);
+    }
+
+    void _push(const AssetIdT &id, std::uint64_t version) {
+      std::lock_guard lock {_mutex};
+      _changes.push_back({id, version});
+    }
+
+    std::mutex _mutex;
+    std::vector<Change> _changes;
+  };
+
   static constexpr Manager& get() {
     static Manager instance;
     return instance;
   }
 
+  // replaces the entry stored under 'id' (if any)
   template<typename ...Args>
   constexpr Handle create(const AssetIdT &id, Args&& ...args) noexcept {
-    _table.insert_or_assign(id, T{std::forward<Args>(args)...});
-    return { _table.find(id) };
+    return insert_or_assign(id, std::forward<Args>(args)...);
   }
 
   template<typename ...Args>
-  constexpr Handle create(UnnamedTag, Args&& ...args) noexcept {
-    static std::atomic_int cnt = 0;
-    int id = cnt++;
-    std::string idstr = std::to_string(id);
-    _table.insert_or_assign(idstr, T{std::forward<Args>(args)...});
-    return { _table.find(idstr) };
+  constexpr UnnamedHandle create(UnnamedTag, Args&& ...args) noexcept {
+    MR_MANAGER_TRACE(create, std::string_view {});
+    T *ptr = _construct(std::forward<Args>(args)...);
+    UnnamedId id = _unnamed.insert(ptr);
+    if constexpr (PolicyT::shared) {
+      _block(ptr)->state.unnamed = id;
+    }
+    _enforce_budgets(nullptr);
+    return { id, ptr };
   }
 
+  // keeps the existing entry; T is only constructed when 'id' is absent
+  template<typename ...Args>
+  constexpr Handle try_emplace(const AssetIdT &id, Args&& ...args) noexcept {
+    MR_MANAGER_TRACE(create, id);
+    if constexpr (_cold) {
+      if (std::optional<Handle> handle = _thaw(id)) {
+        return std::move(*handle);
+      }
+    }
+    auto [it, inserted] = _table.try_emplace(id, id, std::in_place, std::forward<Args>(args)...);
+    if (inserted) {
+      _link_static(it->second);
+      _changed(id, it->second.version);
+      _enforce_budgets(it->second.ptr);
+    } else {
+      _touch(it->second.ptr);
+    }
+    return { std::move(it) };
+  }
+
+  // constructs T in pool storage and replaces the existing entry (if any)
+  template<typename ...Args>
+  constexpr Handle insert_or_assign(const AssetIdT &id, Args&& ...args) noexcept {
+    MR_MANAGER_TRACE(create, id);
+    Entry entry {id, std::in_place, std::forward<Args>(args)...};
+    Handle handle;
+    if constexpr (MR_MANAGER_ENABLE_STATS) {
+      // try_emplace leaves 'entry' untouched when 'id' exists, which tells overwrites apart
+      auto [it, inserted] = _table.try_emplace(id, std::move(entry));
+      if (inserted) {
+        handle = {std::move(it)};
+      } else {
+        _counters().overwrites.increment();
+        handle = {_table.insert_or_assign(id, std::move(entry)).first};
+      }
+    } else {
+      handle = {_table.insert_or_assign(id, std::move(entry)).first};
+    }
+    _drop_cold(id);
+    _link_static(handle.it->second);
+    _changed(id, handle.it->second.version);
+    _enforce_budgets(handle.it->second.ptr);
+    return handle;
+  }
+
+  // swaps a new object in for the entry stored under 'id', if there is one. Readers holding
+  // a Handle keep the previous object until they let go of it, as after an overwrite;
+  // subscribers see the new version.
+  template<typename ...Args>
+  std::optional<Handle> replace(const AssetIdT &id, Args&& ...args) noexcept {
+    if (_table.find(id) == _table.end()) {
+      if constexpr (_cold) {
+        if (_cold_entries.find(id) != _cold_entries.cend()) {
+          return insert_or_assign(id, std::forward<Args>(args)...);
+        }
+      }
+      return std::nullopt;
+    }
+    auto it = _table.assign(id, Entry {id, std::in_place, std::forward<Args>(args)...});
+    if (!it) {
+      return std::nullopt;
+    }
+    _counters().overwrites.increment();
+    Handle handle {std::move(*it)};
+    _link_static(handle.it->second);
+    _changed(id, handle.it->second.version);
+    _enforce_budgets(handle.it->second.ptr);
+    return handle;
+  }
+
+  // starts recording changes to named entries, until the returned queue is destroyed.
+  // Writes only check an atomic count while nobody subscribes.
+  ChangeQueue subscribe() {
+    return ChangeQueue {};
+  }
+
+  // runs loader() on 'executor' and creates (replacing) the entry from its result
+  // a call for an id whose load is still running waits on that load instead of starting another one
+  // the future fails with the loader's exception, or with std::out_of_range if the entry
+  // was erased before the caller's continuation ran
+  template <typename Loader>
+    requires std::is_constructible_v<T, std::invoke_result_t<Loader &>>
+  folly::SemiFuture<Handle> create_async(const AssetIdT &id, Loader &&loader, folly::Executor::KeepAlive<> executor) {
+    auto [load, leader] = _join_load(id);
+    if (leader) {
+      executor->add([this, id, load, loader = std::forward<Loader>(loader)]() mutable {
+        _finish_load(id, load, folly::makeTryWith([&] {
+          create(id, std::invoke(loader));
+          return folly::unit;
+        }));
+      });
+    }
+    return load->getSemiFuture().deferValue([this, id](folly::Unit) {
+      return _loaded(id);
+    });
+  }
+
+  // create_async() which keeps an existing entry: returns it right away, or runs loader() on
+  // 'executor' unless the entry shows up before the loader starts. Calls missing the same id
+  // share one load with each other and with create_async() and find_or_load()
+  template <typename Loader>
+    requires std::is_constructible_v<T, std::invoke_result_t<Loader &>>
+  folly::SemiFuture<Handle> find_or_create_async(const AssetIdT &id, Loader &&loader, folly::Executor::KeepAlive<> executor) {
+    if (std::optional<Handle> handle = find(id)) {
+      return folly::makeSemiFuture(std::move(*handle));
+    }
+    auto [load, leader] = _join_load(id);
+    if (leader) {
+      executor->add([this, id, load, loader = std::forward<Loader>(loader)]() mutable {
+        _finish_load(id, load, folly::makeTryWith([&] {
+          // a load which finished between the find() and _join_load() above already created it
+          if (!find(id)) {
+            create(id, std::invoke(loader));
+          }
+          return folly::unit;
+        }));
+      });
+    }
+    return load->getSemiFuture().deferValue([this, id](folly::Unit) {
+      return _loaded(id);
+    });
+  }
+
+#if FOLLY_HAS_COROUTINES
+  // returns the existing entry without suspending; on a miss, awaits loader() (or calls it,
+  // unless it returns an awaitable) and creates the entry from the result. Coroutines and
+  // create_async() calls missing the same id share one load.
+  template <typename Loader>
+  folly::coro::Task<Handle> find_or_load(AssetIdT id, Loader loader) {
+    if (std::optional<Handle> handle = find(id)) {
+      co_return std::move(*handle);
+    }
+    auto [load, leader] = _join_load(id);
+    if (leader) {
+      _finish_load(id, load, co_await folly::coro::co_awaitTry(_load(id, std::move(loader))));
+    }
+    co_await load->getSemiFuture();
+    co_return _loaded(id);
+  }
+#endif
+
   constexpr std::optional<Handle> find(const AssetIdT &id) const noexcept {
+    return _find(id);
+  }
+
+  // heterogeneous lookup (e.g. std::string_view or const char * for string ids) when
+  // asset_hash_t<T> and asset_key_equal_t<T> are transparent: the table is probed with
+  // 'id' itself, so no AssetIdT is built
+  template <typename K> requires _transparent<K>
+  constexpr std::optional<Handle> find(const K &id) const noexcept {
+    return _find(id);
+  }
+
+  // the same for ids with a hasher which isn't transparent: the probe key is a per-thread
+  // buffer which is reused, so no allocation happens once it is large enough. Strings probing
+  // InternedId tables are only looked up in the intern pool, so a string never interned is
+  // a miss right away and probes don't grow the pool
+  template <typename K>
+    requires (!_transparent<K> && !std::is_same_v<std::remove_cvref_t<K>, AssetIdT> && std::is_assignable_v<AssetIdT &, const K &>)
+  constexpr std::optional<Handle> find(const K &id) const noexcept {
+    if constexpr (std::is_same_v<AssetIdT, InternedId> && std::is_convertible_v<const K &, std::string_view>) {
+      std::optional<InternedId> key = InternedId::lookup(_hashed(id));
+      if (!key) {
+        _counters().misses.increment();
+        return std::nullopt;
+      }
+      return _find(*key);
+    } else {
+      thread_local AssetIdT key;
+      key = id;
+      return _find(key);
+    }
+  }
+
+  // find() for an id of AssetPolicy<T>::static_assets without hashing: the slot is picked at
+  // compile time, so a hit is one load. Like CompactHandle::get(), the pointer must not outlive
+  // a concurrent erase unless reclamation is deferred and collect() runs at a quiescent point.
+  template <LiteralId S>
+  T* find_static(StaticId<S>) const noexcept {
+    constexpr size_t index = StaticAssetsT::template index_of<S>;
+    static_assert(index < StaticAssetsT::size, "the id isn't one of AssetPolicy<T>::static_assets");
+    T *ptr = _statics[index].load(std::memory_order_acquire);
+    if (ptr == nullptr) [[unlikely]] {
+      // an erase racing with a create may have cleared the slot of a live entry
+      std::optional<Handle> handle = find(StaticId<S>::str);
+      return handle ? handle->it->second.ptr : nullptr;
+    }
+    _counters().hits.increment();
+    _touch(ptr);
+    return ptr;
+  }
+
+  // find() through a small direct-mapped cache of this thread's recent hits, for types whose
+  // AssetPolicy<T>::lookup_cache is set. A hit costs the id's hash, one probe, one acquire
+  // load of the epoch every write to the type bumps and a compare with the id in the table;
+  // so it pays off when writes are rare. A miss caches a pointer to the table's id rather than
+  // a copy, which the epoch keeps valid like the object pointer.
+  // Like CompactHandle::get(), the pointer must not outlive a concurrent erase unless
+  // reclamation is deferred and collect() runs at a quiescent point.
+  template <typename K>
+  T* find_cached(const K &id) const noexcept requires (PolicyT::lookup_cache != 0) {
+    size_t hash = asset_hash_t<T> {}(id);
+    CacheSlot &slot = _cache()[hash & (PolicyT::lookup_cache - 1)];
+    // acquire, so that an entry cached under the current epoch is seen as it was published
+    if (slot.ptr != nullptr && slot.hash == hash && slot.epoch == _epoch.load(std::memory_order_acquire)
+        && asset_key_equal_t<T> {}(*slot.id, id)) [[likely]] {
+      _counters().hits.increment();
+      _touch(slot.ptr);
+      return slot.ptr;
+    }
+    // read before the lookup, so a write racing with it leaves the slot outdated
+    std::uint64_t epoch = _epoch.load(std::memory_order_acquire);
+    std::optional<Handle> handle = find(id);
+    if (!handle) {
+      return nullptr;
+    }
+    slot.hash = hash;
+    slot.id = &handle->it->first;
+    slot.ptr = handle->it->second.ptr;
+    slot.epoch = epoch;
+    return slot.ptr;
+  }
+
+  constexpr std::optional<UnnamedHandle> find(UnnamedId id) const noexcept {
+    MR_MANAGER_TRACE(find, std::string_view {});
+    T *ptr = _unnamed.find(id);
+    if (ptr == nullptr) [[unlikely]] {
+      _counters().misses.increment();
+      return std::nullopt;
+    }
+    _counters().hits.increment();
+    return UnnamedHandle{id, ptr};
+  }
+
+  // grows the table and the pool up front for 'count' more entries, so that a run of creates
+  // (e.g. a level load) doesn't rehash or add arenas on the way. That is all a batch of creates
+  // can share: folly::ConcurrentHashMap locks inside each insert and has no batched one.
+  // Throws std::bad_alloc if the pool can't grow
+  void reserve(size_t count) {
+    _table.reserve(_table.size() + count);
+    _slabs().reserve(count);
+  }
+
+  // hint that 'id' is about to be found by find_snapshot(), for snapshot types: pulls the
+  // snapshot slot its lookup starts at into cache, at the cost of hashing the id. The hash
+  // map keeps its buckets to itself, so there is no such hint for find()
+  void prefetch(const AssetIdT &id) const noexcept requires PolicyT::snapshot {
+    folly::rcu_reader guard;
+    if (const SnapshotT *snapshot = _snapshot.load(std::memory_order_acquire)) {
+      snapshot->prefetch(id);
+    }
+  }
+
+  void prefetch(std::span<const AssetIdT> ids) const noexcept requires PolicyT::snapshot {
+    folly::rcu_reader guard;
+    if (const SnapshotT *snapshot = _snapshot.load(std::memory_order_acquire)) {
+      for (const AssetIdT &id : ids) {
+        snapshot->prefetch(id);
+      }
+    }
+  }
+
+  // find_bulk() with part of the misses of a group of lookups overlapped: the hash map is
+  // probed one id at a time, but the objects of a group are all prefetched before any of them
+  // is touched or handed out. For snapshot types, the group is looked up in the snapshot
+  // first, whose slots and objects are prefetched together, so the probes find them in cache.
+  // Returns the number of hits
+  size_t find_batch(std::span<const AssetIdT> ids, std::span<std::optional<Handle>> out) const noexcept {
+    assert(ids.size() == out.size());
+    static constexpr size_t group = 8;
+    size_t found = 0;
+    for (size_t begin = 0; begin < ids.size(); begin += group) {
+      size_t end = std::min(begin + group, ids.size());
+      if constexpr (PolicyT::snapshot) {
+        folly::rcu_reader guard;
+        if (const SnapshotT *snapshot = _snapshot.load(std::memory_order_acquire)) {
+          std::array<const T *, group> objects;
+          snapshot->find_batch(ids.subspan(begin, end - begin), std::span<const T *> {objects.data(), end - begin});
+        }
+      }
+      for (size_t i = begin; i < end; i++) {
+        auto it = _table.find(ids[i]);
+        if (it == _table.end()) {
+          out[i] = std::nullopt;
+          continue;
+        }
+        detail::prefetch(it->second.ptr);
+        out[i] = Handle{std::move(it)};
+      }
+      for (size_t i = begin; i < end; i++) {
+        if (out[i]) {
+          _counters().hits.increment();
+          _touch(out[i]->it->second.ptr);
+          found++;
+        } else if constexpr (_cold) {
+          // thawing decodes the object anyway, so there is nothing to overlap
+          out[i] = find(ids[i]);
+          found += out[i].has_value();
+        } else {
+          _counters().misses.increment();
+        }
+      }
+    }
+    return found;
+  }
+
+  // out[i] is set to the handle for ids[i], or std::nullopt; returns the number of hits
+  size_t find_bulk(std::span<const AssetIdT> ids, std::span<std::optional<Handle>> out) const noexcept {
+    return find_batch(ids, out);
+  }
+
+  constexpr size_t find_bulk(std::span<const UnnamedId> ids, std::span<std::optional<UnnamedHandle>> out) const noexcept {
+    assert(ids.size() == out.size());
+    size_t found = 0;
+    for (size_t i = 0; i < ids.size(); i++) {
+      out[i] = find(ids[i]);
+      found += out[i].has_value();
+    }
+    return found;
+  }
+
+  // returns the number of removed entries
+  // handles to a removed entry stay valid until reclamation, as after an overwrite
+  constexpr size_t erase(const AssetIdT &id) noexcept {
+    MR_MANAGER_TRACE(erase, id);
+    size_t erased = _table.erase(id);
+    if constexpr (_cold) {
+      erased = std::max(erased, _cold_entries.erase(id));
+    }
+    if (erased != 0) {
+      _forget_static(id);
+      _changed(id, 0);
+    }
+    _counters().erases.increment(erased);
+    return erased;
+  }
+
+  // the object is destroyed immediately, so its pool block is reused by the next create on this thread
+  // (unless reclamation is deferred); handles to it are invalidated
+  constexpr size_t erase(UnnamedId id) noexcept {
+    MR_MANAGER_TRACE(erase, std::string_view {});
+    T *ptr = _unnamed.erase(id);
+    if (ptr == nullptr) {
+      return 0;
+    }
+    _counters().erases.increment();
+    _drop(ptr);
+    return 1;
+  }
+
+  constexpr size_t erase(std::span<const AssetIdT> ids) noexcept {
+    size_t erased = 0;
+    for (const AssetIdT &id : ids) {
+      erased += erase(id);
+    }
+    _republish();
+    return erased;
+  }
+
+  constexpr size_t erase(std::span<const UnnamedId> ids) noexcept {
+    size_t erased = 0;
+    for (UnnamedId id : ids) {
+      erased += erase(id);
+    }
+    return erased;
+  }
+
+  // erases every named entry for which pred(const AssetIdT &, const T &) holds,
+  // and every unnamed one if pred is also invocable as pred(UnnamedId, const T &);
+  // entries in the cold tier aren't visited
+  template <typename Pred>
+  constexpr size_t erase_if(Pred &&pred) noexcept {
+    size_t erased = 0;
+    for (auto it = _table.cbegin(); it != _table.cend();) {
+      if (pred(it->first, std::as_const(*it->second.ptr))) {
+        _unlink_static(it->second);
+        _changed(it->first, 0);
+        it = _table.erase(it);
+        erased++;
+      } else {
+        ++it;
+      }
+    }
+    // _changed() ran before each entry was gone, so lookups may have cached it again
+    _invalidate_caches();
+    _counters().erases.increment(erased);
+    if constexpr (std::is_invocable_r_v<bool, Pred &, UnnamedId, const T &>) {
+      _unnamed.for_each([&](UnnamedId id, T *ptr) {
+        if (pred(id, std::as_const(*ptr))) {
+          erased += erase(id);
+        }
+      });
+    }
+    _republish();
+    return erased;
+  }
+
+  // removes the entry and moves its object out
+  // handles still pointing at the entry observe the moved-from object
+  constexpr std::optional<T> extract(const AssetIdT &id) noexcept requires std::is_move_constructible_v<T> {
+    if constexpr (_cold) {
+      _thaw(id);
+    }
     auto it = _table.find(id);
-    if (it == _table.end()) [[unlikely]] {
+    if (it == _table.end() || _table.erase_if_equal(id, it->second) == 0) {
       return std::nullopt;
     }
-    return Handle{std::move(it)};
+    _unlink_static(it->second);
+    _changed(id, 0);
+    _counters().erases.increment();
+    return std::optional<T>{std::move(*it->second.ptr)};
+  }
+
+  constexpr std::optional<T> extract(UnnamedId id) noexcept requires std::is_move_constructible_v<T> {
+    T *ptr = _unnamed.erase(id);
+    if (ptr == nullptr) {
+      return std::nullopt;
+    }
+    _counters().erases.increment();
+    std::optional<T> value {std::move(*ptr)};
+    _drop(ptr);
+    return value;
   }
 
   constexpr void clear() noexcept {
+    if (_subscriber_count.load(std::memory_order_relaxed) != 0) {
+      for (auto it = _table.cbegin(); it != _table.cend(); ++it) {
+        _changed(it->first, 0);
+      }
+    }
     _table.clear();
+    if constexpr (_cold) {
+      _cold_entries.clear();
+    }
+    _invalidate_caches();
+    for (auto &ptr : _statics) {
+      ptr.store(nullptr, std::memory_order_release);
+    }
+    _unnamed.clear(_drop);
+    _republish();
+  }
+
+  // lookup against the table as of the last publish(): an RCU read section and a probe of
+  // an immutable open-addressing table, with no hazard pointer and no atomic read-modify-write.
+  // Accepts any key asset_hash_t<T> and asset_key_equal_t<T> accept (e.g. std::string_view).
+  template <typename K>
+  std::optional<SnapshotHandle> find_snapshot(const K &id) const noexcept requires PolicyT::snapshot {
+    folly::rcu_reader guard;
+    const SnapshotT *snapshot = _snapshot.load(std::memory_order_acquire);
+    T *ptr = snapshot == nullptr ? nullptr : snapshot->find(id);
+    if (ptr == nullptr) {
+      return std::nullopt;
+    }
+    return SnapshotHandle{std::move(guard), ptr};
+  }
+
+  // out[i] = the object find_snapshot(ids[i]) would find, or nullptr, probing groups of ids
+  // side by side so their cache misses overlap. The pointers are only valid within the
+  // read section 'guard' holds. Returns the number of hits
+  template <typename K>
+  size_t find_snapshot_batch(std::span<const K> ids, std::span<const T *> out, [[maybe_unused]] const folly::rcu_reader &guard) const noexcept
+    requires PolicyT::snapshot {
+    assert(ids.size() == out.size());
+    const SnapshotT *snapshot = _snapshot.load(std::memory_order_acquire);
+    if (snapshot == nullptr) {
+      std::ranges::fill(out, nullptr);
+      return 0;
+    }
+    return snapshot->find_batch(ids, out);
+  }
+
+  // rebuilds the snapshot from the table. Single writes don't publish, so batches of them
+  // pay for one rebuild (bulk operations and clear() publish on their own). Readers switch
+  // over without waiting; the previous snapshot, and objects only it still referenced, are
+  // released after an RCU grace period.
+  void publish() noexcept requires PolicyT::snapshot {
+    std::lock_guard lock {_publish_mutex};
+    std::vector<std::pair<AssetIdT, T *>> items;
+    items.reserve(_table.size());
+    for (auto it = _table.cbegin(); it != _table.cend(); ++it) {
+      _block(it->second.ptr)->state.refs.fetch_add(1, std::memory_order_relaxed);
+      items.emplace_back(it->first, it->second.ptr);
+    }
+    SnapshotT *old = _snapshot.exchange(new SnapshotT(items), std::memory_order_acq_rel);
+    if (old != nullptr) {
+      folly::rcu_retire(old, [](SnapshotT *snapshot) {
+        snapshot->for_each(_drop);
+        delete snapshot;
+      });
+    }
   }
 
   constexpr size_t size() const noexcept {
-    return _table.size();
+    return _table.size() + _unnamed.size();
+  }
+
+  // writes the named entries to 'path', each object's bytes laid out as in the pool, so that
+  // load_from() can map the file and use it as pool memory. Objects are copied as they are,
+  // so they must not be written to meanwhile; throws std::runtime_error if writing fails.
+  void save_to(const std::filesystem::path &path) const requires _storable {
+    std::vector<std::byte> blocks;
+    std::vector<std::byte> ids;
+    size_t block_size = _memory_resource.block_size();
+    for (auto it = _table.cbegin(); it != _table.cend(); ++it) {
+      blocks.resize(blocks.size() + block_size);
+      std::memcpy(blocks.data() + blocks.size() - block_size, it->second.ptr, sizeof(T));
+      detail::write_id(ids, it->first);
+    }
+
+    detail::FileHeader header;
+    header.object_size = sizeof(T);
+    header.object_align = alignof(T);
+    header.block_size = block_size;
+    header.count = blocks.size() / block_size;
+    header.blocks = detail::file_page;
+    header.ids = header.blocks + blocks.size();
+    header.bytes = header.ids + ids.size();
+    std::vector<std::byte> head(detail::file_page);
+    std::memcpy(head.data(), &header, sizeof(header));
+    std::span<const std::byte> parts[] = {head, blocks, ids};
+    detail::write_file(path, parts);
+  }
+
+  // maps a file written by save_to() and adds its entries, replacing existing ones with the
+  // same ids. The mapping becomes pool memory: objects are used in place rather than
+  // constructed, and their blocks are recycled once erased. Returns the number of entries;
+  // throws std::system_error if the file can't be mapped and std::runtime_error if it wasn't
+  // written for T or its ids are corrupt, in which case nothing is added.
+  size_t load_from(const std::filesystem::path &path) requires _storable {
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(_slabs())>, SlabResource>,
+                  "files can't be loaded into resources with slabs of their own");
+    static_assert(_block_align <= detail::file_page);
+    std::span<std::byte> file = detail::map_file(path);
+    detail::FileHeader header;
+    std::memcpy(&header, file.data(), std::min(sizeof(header), file.size()));
+    size_t block_size = _memory_resource.block_size();
+    if (file.size() < sizeof(header) || header.magic != detail::file_magic || header.version != detail::file_version
+        || header.object_size != sizeof(T) || header.object_align != alignof(T) || header.block_size != block_size
+        || header.bytes != file.size() || !detail::valid_layout(header, block_size, detail::min_id_bytes<AssetIdT>)) {
+      detail::unmap_file(file);
+      throw std::runtime_error("mr::Manager: " + path.string() + " wasn't saved for this type");
+    }
+
+    // all ids are parsed before anything is adopted, so a corrupt id section leaves the manager untouched
+    std::vector<AssetIdT> ids;
+    try {
+      ids.reserve(header.count);
+      std::span<const std::byte> rest = file.subspan(header.ids);
+      for (size_t i = 0; i < header.count; i++) {
+        ids.push_back(detail::read_id<AssetIdT>(rest));
+      }
+      if (!rest.empty()) {
+        throw std::runtime_error("mr::Manager: trailing bytes after the ids in file");
+      }
+    } catch (...) {
+      detail::unmap_file(file);
+      throw;
+    }
+
+    std::byte *blocks = file.data() + header.blocks;
+    _memory_resource.adopt(blocks, header.count);
+    _table.reserve(_table.size() + header.count);
+    for (size_t i = 0; i < header.count; i++) {
+      auto *block = reinterpret_cast<Block *>(blocks + i * block_size);
+      if constexpr (_stateful) {
+        new (&block->state) detail::BlockState<AssetIdT, _stateful, PolicyT::shared>;
+      }
+      const AssetIdT &id = ids[i];
+      auto it = _table.insert_or_assign(id, Entry {id, &block->value}).first;
+      _drop_cold(id);
+      _link_static(it->second);
+      _changed(id, it->second.version);
+    }
+    _counters().creates.increment(header.count);
+    _enforce_budgets(nullptr);
+    _republish();
+    return header.count;
+  }
+
+  // f(T &) for every object which isn't destroyed yet, named or unnamed, walking the pool
+  // arenas in address order through the liveness bitmaps an iterable policy keeps. Objects
+  // replaced or erased but not reclaimed yet are visited too. Like CompactHandle::get(), it
+  // must not overlap erases or overwrites unless reclamation is deferred and collect() runs
+  // at a quiescent point.
+  template <typename F>
+  void for_each(F &&f) requires _iterable {
+    for (const BlockRange &range : _slabs().live_ranges()) {
+      range.for_each([&](void *block) { f(static_cast<Block *>(block)->value); });
+    }
+  }
+
+  // for_each() with the arenas split into runs of 'grain' blocks, which the calling thread
+  // and tasks on 'executor' take in turn; returns once every run is done. f is called
+  // concurrently and must not throw.
+  template <typename F>
+  void parallel_for_each(folly::Executor::KeepAlive<> executor, F &&f, size_t grain = 4096) requires _iterable {
+    struct Walk {
+      explicit Walk(std::vector<BlockRange> runs) : ranges(std::move(runs)), done(static_cast<std::ptrdiff_t>(ranges.size())) {}
+
+      std::vector<BlockRange> ranges;
+      std::atomic<size_t> next {0};
+      std::latch done;
+    };
+    auto walk = std::make_shared<Walk>(_slabs().live_ranges(grain));
+    // tasks only touch f after claiming a run, and the caller waits for every run, so late
+    // tasks which find nothing left don't outlive f
+    auto run = [walk, &f] {
+      for (size_t i; (i = walk->next.fetch_add(1, std::memory_order_relaxed)) < walk->ranges.size();) {
+        walk->ranges[i].for_each([&](void *block) { f(static_cast<Block *>(block)->value); });
+        walk->done.count_down();
+      }
+    };
+    size_t workers = std::min<size_t>(walk->ranges.size(), std::max(std::thread::hardware_concurrency(), 1u));
+    for (size_t i = 1; i < workers; i++) {
+      executor->add(run);
+    }
+    run();
+    walk->done.wait();
+  }
+
+  // destroys, on the calling thread, every object retired before the call
+  // returns the number of destroyed objects (always 0 unless reclamation is deferred)
+  constexpr size_t collect() noexcept {
+    if constexpr (PolicyT::reclamation == Reclamation::deferred) {
+      return _retired.collect();
+    } else {
+      return 0;
+    }
+  }
+
+  // summed cost() of the named entries, including erased ones which aren't reclaimed yet
+  // (always 0 without a budget)
+  constexpr size_t cost() const noexcept {
+    return _cost.load(std::memory_order_relaxed);
+  }
+
+  // objects waiting for collect()
+  constexpr size_t retired() const noexcept {
+    if constexpr (PolicyT::reclamation == Reclamation::deferred) {
+      return _retired.pending();
+    } else {
+      return 0;
+    }
+  }
+
+  // bytes of the pool blocks held by objects which aren't destroyed yet
+  size_t memory() const noexcept {
+    return _live_blocks() * _memory_resource.block_size();
+  }
+
+  // evicts named entries, picked as by the budget sweep, until about 'bytes' of pool blocks
+  // are released (once the entries are reclaimed); returns the bytes released
+  size_t trim(size_t bytes) noexcept {
+    size_t block = _memory_resource.block_size();
+    size_t count = (bytes + block - 1) / block;
+    return _sweep(nullptr, [&](size_t evicted) { return evicted >= count; }) * block;
+  }
+
+  // moves the named entries not found since the previous call (going by the same bits as the
+  // budget sweep) to the cold tier, skipping entries held by a SharedHandle. So, called
+  // periodically, entries go cold once idle for a whole period. Handles to them stay valid
+  // until reclamation, as after an erase. Returns the number of entries moved.
+  size_t cool() noexcept requires _cold {
+    size_t cooled = 0;
+    for (auto it = _table.cbegin(); it != _table.cend(); ++it) {
+      T *ptr = it->second.ptr;
+      if (!_evictable(ptr)) {
+        continue;
+      }
+      std::uint64_t version = it->second.version;
+      std::vector<std::byte> bytes;
+      CodecT::encode(std::as_const(*ptr), bytes);
+      _cold_entries.insert_or_assign(it->first, ColdEntry {std::move(bytes), version});
+      if (_table.erase_key_if(it->first, [&](const Entry &entry) { return entry.ptr == ptr; }) == 0) {
+        // replaced in the meantime, so the copy is outdated
+        _cold_entries.erase_key_if(it->first, [&](const ColdEntry &cold) { return cold.version == version; });
+        continue;
+      }
+      _unlink_static(it->second);
+      cooled++;
+    }
+    if (cooled != 0) {
+      _invalidate_caches();
+    }
+    return cooled;
+  }
+
+  // entries in the cold tier
+  size_t cold_size() const noexcept requires _cold {
+    return _cold_entries.size();
+  }
+
+  // sampled durations of creates, finds, erases and entry reclamation, indexed by TraceOp;
+  // all zero unless MR_MANAGER_ENABLE_TRACING is set
+  LatencyHistograms latencies() const noexcept {
+    return _histograms().read();
+  }
+
+  // reads every thread's counters, so it is meant for periodic export rather than hot paths
+  ManagerStats stats() const noexcept {
+    ManagerStats stats;
+    detail::StatCounters &counters = _counters();
+    stats.hits = counters.hits.readFull();
+    stats.misses = counters.misses.readFull();
+    stats.creates = counters.creates.readFull();
+    stats.overwrites = counters.overwrites.readFull();
+    stats.erases = counters.erases.readFull();
+    stats.evictions = counters.evictions.readFull();
+    stats.destroyed = counters.destroyed.readFull();
+
+    stats.entries = _table.size() + _unnamed.size();
+    size_t live = stats.creates > stats.destroyed ? stats.creates - stats.destroyed : 0;
+    stats.bytes_in_use = live * _memory_resource.block_size();
+    stats.pool_capacity = _slabs().capacity();
+    stats.pool_arenas = _slabs().arena_count();
+    // objects stay constructed until reclaimed, so the excess over the entries is the backlog
+    stats.unreclaimed = live > stats.entries ? live - stats.entries : 0;
+    return stats;
   }
 
 private:
-  constexpr Manager() noexcept = default;
-  constexpr ~Manager() noexcept = default;
+  Manager() noexcept {
+    Registry::get().add({
+      &typeid(T),
+      []() noexcept { return get().stats(); },
+      []() noexcept { return get().memory(); },
+      []() noexcept { get().clear(); },
+      [](size_t bytes) noexcept { return get().trim(bytes); },
+      []() noexcept { return get().latencies(); },
+    });
+  }
+
+  static T * _resolve(SlotId slot) noexcept {
+    if constexpr (PolicyT::compact_handles) {
+      if (slot.index & CompactHandle::named_bit) {
+        return _named.find({slot.index & ~CompactHandle::named_bit, slot.generation});
+      }
+    }
+    return _unnamed.find(slot);
+  }
+
+  static std::uint64_t _next_version() noexcept {
+    if constexpr (_versioned) {
+      return _versions.fetch_add(1, std::memory_order_relaxed) + 1;
+    } else {
+      return 1;
+    }
+  }
+
+  static auto _insert_named([[maybe_unused]] T *ptr) noexcept {
+    if constexpr (PolicyT::compact_handles) {
+      return _named.insert(ptr);
+    } else {
+      return std::tuple<> {};
+    }
+  }
+
+  ~Manager() noexcept {
+    Registry::get().remove(typeid(T));
+    if (SnapshotT *snapshot = _snapshot.exchange(nullptr, std::memory_order_acq_rel)) {
+      snapshot->for_each(_drop);
+      delete snapshot;
+    }
+    _unnamed.clear(_drop);
+    collect();
+  }
+
+  static Block * _block(T *ptr) noexcept {
+    return reinterpret_cast<Block *>(ptr);
+  }
+
+  // a resource with slabs of its own (such as NumaResource) grows and reports them itself,
+  // _memory_resource then only describes the block layout
+  static auto & _slabs() noexcept {
+    if constexpr (requires { _memory_pool_resource.arena_count(); }) {
+      return _memory_pool_resource;
+    } else {
+      return _memory_resource;
+    }
+  }
+
+  // immortal, so objects destroyed during static destruction can still be counted
+  static detail::StatCounters & _counters() noexcept {
+    static detail::StatCounters *counters = new detail::StatCounters;
+    return *counters;
+  }
+
+  // objects constructed and not destroyed yet, from the counters every pool block goes through
+  static size_t _live_blocks() noexcept {
+    std::uint64_t creates = _counters().creates.readFull();
+    std::uint64_t destroyed = _counters().destroyed.readFull();
+    return creates > destroyed ? creates - destroyed : 0;
+  }
+
+  // immortal like the counters, for entries reclaimed during static destruction
+  static detail::TraceHistograms & _histograms() noexcept {
+    static detail::TraceHistograms *histograms = new detail::TraceHistograms;
+    return *histograms;
+  }
+
+  // the running load for 'id', and whether the caller started it (and so has to run it)
+  std::pair<std::shared_ptr<LoadT>, bool> _join_load(const AssetIdT &id) {
+    auto [it, inserted] = _loading.try_emplace(id, std::make_shared<LoadT>());
+    return {it->second, inserted};
+  }
+
+  // forgets the load before waking its waiters, so a call made after a failure starts a new one
+  void _finish_load(const AssetIdT &id, const std::shared_ptr<LoadT> &load, folly::Try<folly::Unit> &&result) {
+    _loading.erase_key_if(id, [&](const std::shared_ptr<LoadT> &running) { return running == load; });
+    load->setTry(std::move(result));
+  }
+
+  Handle _loaded(const AssetIdT &id) const {
+    std::optional<Handle> handle = find(id);
+    if (!handle) {
+      throw std::out_of_range("mr::Manager: the loaded entry was erased");
+    }
+    return std::move(*handle);
+  }
+
+#if FOLLY_HAS_COROUTINES
+  template <typename Loader>
+  folly::coro::Task<folly::Unit> _load(AssetIdT id, Loader loader) {
+    if constexpr (folly::coro::is_awaitable_v<std::invoke_result_t<Loader &>>) {
+      create(id, co_await std::invoke(loader));
+    } else {
+      create(id, std::invoke(loader));
+    }
+    co_return folly::unit;
+  }
+#endif
+
+  template <typename K>
+  std::optional<Handle> _find(const K &id) const noexcept {
+    MR_MANAGER_TRACE(find, id);
+    auto it = _table.find(id);
+    if (it == _table.end()) [[unlikely]] {
+      if constexpr (_cold) {
+        if (std::optional<Handle> handle = get()._thaw(id)) {
+          _counters().hits.increment();
+          return handle;
+        }
+      }
+      _counters().misses.increment();
+      return std::nullopt;
+    }
+    _counters().hits.increment();
+    _touch(it->second.ptr);
+    return Handle{std::move(it)};
+  }
+
+  // decodes the cold copy of 'id' (if any) back into the table. Concurrent thaws of an id
+  // share the entry inserted first, and a copy which an erase or a create made outdated
+  // in the meantime is dropped again
+  template <typename K>
+  std::optional<Handle> _thaw(const K &probe) noexcept {
+    auto cold = _cold_entries.find(probe);
+    if (cold == _cold_entries.cend()) {
+      return std::nullopt;
+    }
+    const AssetIdT &id = cold->first;
+    std::uint64_t version = cold->second.version;
+    auto [it, inserted] = _table.try_emplace(id, id, std::in_place, CodecT::decode(std::span<const std::byte> {cold->second.bytes}));
+    if (inserted) {
+      if (_cold_entries.erase_key_if(id, [&](const ColdEntry &entry) { return entry.version == version; }) == 0) {
+        T *ptr = it->second.ptr;
+        _table.erase_key_if(id, [&](const Entry &entry) { return entry.ptr == ptr; });
+        it = _table.find(id);
+        if (it == _table.end()) {
+          return std::nullopt;
+        }
+      } else {
+        _link_static(it->second);
+        _enforce_budgets(it->second.ptr);
+      }
+    }
+    _touch(it->second.ptr);
+    return Handle{std::move(it)};
+  }
+
+  // a write to a named entry supersedes its cold copy
+  void _drop_cold([[maybe_unused]] const AssetIdT &id) noexcept {
+    if constexpr (_cold) {
+      _cold_entries.erase(id);
+    }
+  }
+
+  // a hit is one relaxed store, skipped when the bit is already set
+  static void _touch(T *ptr) noexcept {
+    if constexpr (PolicyT::budget != 0 || _cold) {
+      auto &referenced = _block(ptr)->state.referenced;
+      if (!referenced.load(std::memory_order_relaxed)) {
+        referenced.store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // runs after every create: sweeps this type down to its budget, and checks the
+  // process-wide one whenever the pool has grown (so not on every create)
+  void _enforce_budgets([[maybe_unused]] T *created) noexcept {
+    if constexpr (PolicyT::budget != 0) {
+      auto within = [](size_t) { return _cost.load(std::memory_order_relaxed) <= PolicyT::budget; };
+      if (!within(0)) {
+        _sweep(created, within);
+      }
+    }
+    size_t arenas = _slabs().arena_count();
+    if (_arenas.load(std::memory_order_relaxed) != arenas) [[unlikely]] {
+      _arenas.store(arenas, std::memory_order_relaxed);
+      Registry::get().enforce();
+    }
+  }
+
+  // CLOCK sweep, run by one thread at a time, until done(evicted count) holds. The hash map
+  // can't hold a hand between sweeps, so each one starts over at the first entry: the first
+  // pass clears referenced bits, the second evicts whatever wasn't found in between.
+  // 'created' is never evicted. An evicted entry's cost is taken off the total right away
+  // rather than at reclamation, so the next sweep doesn't evict again for entries that are
+  // already gone. Without per-object bookkeeping entries are evicted in map order.
+  template <typename Done>
+  size_t _sweep(T *created, Done &&done) noexcept {
+    if (_sweeping.test_and_set(std::memory_order_acquire)) {
+      return 0;
+    }
+    size_t evicted = 0;
+    for (int pass = 0; pass < 2 && !done(evicted); pass++) {
+      for (auto it = _table.cbegin(); it != _table.cend() && !done(evicted);) {
+        T *ptr = it->second.ptr;
+        if (ptr == created || !_evictable(ptr)) {
+          ++it;
+          continue;
+        }
+        if constexpr (PolicyT::budget != 0) {
+          _block(ptr)->state.evicted = true;
+          _cost.fetch_sub(_block(ptr)->state.cost, std::memory_order_relaxed);
+        }
+        _counters().evictions.increment();
+        _unlink_static(it->second);
+        _changed(it->first, 0);
+        it = _table.erase(it);
+        evicted++;
+      }
+    }
+    if (evicted != 0) {
+      _invalidate_caches();
+    }
+    _sweeping.clear(std::memory_order_release);
+    return evicted;
+  }
+
+  // false for entries held by a SharedHandle, and for ones found since the last sweep,
+  // whose referenced bit is cleared to give them a second chance
+  static bool _evictable([[maybe_unused]] T *ptr) noexcept {
+    if constexpr (_stateful) {
+      auto &state = _block(ptr)->state;
+      bool pinned = PolicyT::shared && state.refs.load(std::memory_order_relaxed) > 1;
+      return !pinned && !state.referenced.exchange(false, std::memory_order_relaxed);
+    } else {
+      return true;
+    }
+  }
+
+  template <typename ...Args>
+  static T * _construct(Args && ...args) noexcept {
+    Block *block = _allocator.allocate(1);
+    assert(block != nullptr);
+    _counters().creates.increment();
+    new (block) Block(std::in_place, std::forward<Args>(args)...);
+    if constexpr (_iterable) {
+      _slabs().set_live(block, true);
+    }
+    return &block->value;
+  }
+
+  static HashedId _hashed(const AssetIdT &id) noexcept {
+    if constexpr (std::is_same_v<AssetIdT, InternedId>) {
+      return {id.str(), id.hash()};
+    } else {
+      return {std::string_view {id}};
+    }
+  }
+
+  // string-like probe keys, with the compile-time hash of "..."_id literals
+  template <typename K> requires (!std::is_same_v<K, AssetIdT>)
+  static HashedId _hashed(const K &id) noexcept {
+    if constexpr (requires { K::str; K::hash; }) {
+      return {K::str, K::hash};
+    } else {
+      return {std::string_view {id}};
+    }
+  }
+
+  // points the static slot of the entry's id (if it has one) at the entry's object
+  static void _link_static([[maybe_unused]] const Entry &entry) noexcept {
+    if constexpr (_has_statics) {
+      if (entry.static_index.value < StaticAssetsT::size) {
+        _statics[entry.static_index.value].store(entry.ptr, std::memory_order_release);
+      }
+    }
+  }
+
+  // clears the static slot if it still points at the entry's object; the entry's destructor
+  // does so too, so a slot never outlives the object it points at
+  static void _unlink_static([[maybe_unused]] const Entry &entry) noexcept {
+    if constexpr (_has_statics) {
+      if (entry.static_index.value < StaticAssetsT::size) {
+        T *ptr = entry.ptr;
+        _statics[entry.static_index.value].compare_exchange_strong(ptr, nullptr, std::memory_order_acq_rel);
+      }
+    }
+  }
+
+  // clears the static slot of an erased id whose entry isn't at hand
+  static void _forget_static([[maybe_unused]] const AssetIdT &id) noexcept {
+    if constexpr (_has_statics) {
+      if (size_t index = StaticAssetsT::find(_hashed(id)); index < StaticAssetsT::size) {
+        _statics[index].store(nullptr, std::memory_order_release);
+      }
+    }
+  }
+
+  // called after every change to a named entry
+  void _changed(const AssetIdT &id, std::uint64_t version) noexcept {
+    _invalidate_caches();
+    if (_subscriber_count.load(std::memory_order_relaxed) == 0) [[likely]] {
+      return;
+    }
+    std::lock_guard lock {_subscribers_mutex};
+    for (ChangeQueue *queue : _subscribers) {
+      queue->_push(id, version);
+    }
+  }
+
+  // must follow the change to the table, so that a lookup which reads the new epoch
+  // can't find the previous state anymore
+  static void _invalidate_caches() noexcept {
+    if constexpr (PolicyT::lookup_cache != 0) {
+      _epoch.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  // the id and the object of an entry, both owned by the table, as of 'epoch'
+  struct CacheSlot {
+    size_t hash = 0;
+    const AssetIdT *id = nullptr;
+    T *ptr = nullptr;
+    std::uint64_t epoch = 0;
+  };
+
+  // function-local, as thread_local static data members of class templates aren't reliable
+  static std::array<CacheSlot, PolicyT::lookup_cache> & _cache() noexcept {
+    thread_local std::array<CacheSlot, PolicyT::lookup_cache> cache;
+    return cache;
+  }
+
+  constexpr void _republish() noexcept {
+    if constexpr (PolicyT::snapshot) {
+      publish();
+    }
+  }
+
+  // releases the reference held by a table entry, an unnamed slot or a snapshot
+  static void _drop(T *ptr) noexcept {
+    if constexpr (_counted) {
+      if (_block(ptr)->state.refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+      }
+    }
+    _destroy(ptr);
+  }
+
+  // releases the reference held by a SharedHandle, evicting the object first if
+  // it is evictable and that reference is the last one besides the table's
+  static void _unshare(T *ptr) noexcept {
+    auto &state = _block(ptr)->state;
+    std::uint32_t refs = state.refs.load(std::memory_order_acquire);
+    do {
+      if (refs == 2 && state.evictable.load(std::memory_order_acquire)) {
+        get()._evict(ptr);
+        refs = state.refs.load(std::memory_order_acquire);
+      }
+    } while (!state.refs.compare_exchange_weak(refs, refs - 1, std::memory_order_acq_rel, std::memory_order_acquire));
+    if (refs == 1) {
+      _destroy(ptr);
+    }
+  }
+
+  // called with a reference held, so the object stays alive throughout
+  void _evict(T *ptr) noexcept {
+    auto &state = _block(ptr)->state;
+    if (state.id.has_value()) {
+      size_t evicted = _table.erase_key_if(*state.id, [&](const Entry &entry) {
+        return entry.ptr == ptr && state.refs.load(std::memory_order_acquire) == 2;
+      });
+      if (evicted != 0) {
+        _forget_static(*state.id);
+        _changed(*state.id, 0);
+      }
+      _counters().evictions.increment(evicted);
+    } else if (_unnamed.erase(state.unnamed) == ptr) {
+      _counters().evictions.increment();
+      _drop(ptr);
+    }
+  }
+
+  static void _destroy(T *ptr) noexcept {
+    if constexpr (PolicyT::reclamation == Reclamation::deferred) {
+      _retired.retire(ptr);
+    } else {
+      _release(ptr);
+    }
+  }
+
+  static void _release(T *ptr) noexcept {
+    _counters().destroyed.increment();
+    Block *block = _block(ptr);
+    if constexpr (_iterable) {
+      _slabs().set_live(block, false);
+    }
+    block->~Block();
+    _allocator.deallocate(block, 1);
+  }
+
+  static inline RetireQueue<T, Manager> _retired {&_release};
+
+  HashMapT _table {PoolT::initial_capacity};
+
+  // encoded entry of the cold tier, with the version the entry had when it went cold
+  struct ColdEntry {
+    std::vector<std::byte> bytes;
+    std::uint64_t version;
+  };
+  using ColdMapT = folly::ConcurrentHashMap<AssetIdT, ColdEntry, asset_hash_t<T>, asset_key_equal_t<T>>;
+  [[no_unique_address]] std::conditional_t<_cold, ColdMapT, std::tuple<>> _cold_entries;
+
+  // loads started by create_async() or find_or_load() which haven't completed yet
+  folly::ConcurrentHashMap<AssetIdT, std::shared_ptr<LoadT>, asset_hash_t<T>, asset_key_equal_t<T>> _loading;
+
+  static inline std::atomic<std::size_t> _cost {0};
+  static inline std::atomic<std::uint64_t> _versions {0};
+  // bumped by every change to a named entry; cached lookups are only valid for the epoch
+  // they were made in. Starts at 1, so empty cache slots never match
+  static inline std::atomic<std::uint64_t> _epoch {1};
+
+  std::mutex _subscribers_mutex;
+  std::vector<ChangeQueue *> _subscribers;
+  std::atomic<std::size_t> _subscriber_count {0};
+  std::atomic_flag _sweeping;
+
+  std::atomic<SnapshotT *> _snapshot {nullptr};
+  std::mutex _publish_mutex;
+  // pool arenas as of the last process-wide budget check
+  std::atomic<std::size_t> _arenas {0};
+
+  // both are constant-initialized, so compact handles resolve without touching the singleton
+  static inline SlotTable<T> _unnamed;
+  static inline SlotTable<T> _named;
 
-  HashMapT _table {_max_elements};
+  // object of the current entry of each static id, nullptr while it has none
+  static inline std::array<std::atomic<T *>, StaticAssetsT::size> _statics {};
 };
 
 } // namespace mr
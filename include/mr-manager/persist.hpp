@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mr::detail {
+// Layout of a file written by Manager<T>::save_to(): the header, the objects back to back
+// with the stride of T's pool blocks (from offset 'blocks', page aligned so the mapped file
+// can serve as pool memory), then the id of each object in the same order
+inline constexpr std::uint64_t file_magic = 0x31676d695f726d00ull; // "\0mr_img1"
+inline constexpr std::uint32_t file_version = 1;
+inline constexpr std::size_t file_page = 4096;
+
+struct FileHeader {
+  std::uint64_t magic = file_magic;
+  std::uint32_t version = file_version;
+  std::uint32_t reserved = 0;
+  std::uint64_t object_size = 0;
+  std::uint64_t object_align = 0;
+  std::uint64_t block_size = 0;
+  std::uint64_t count = 0;
+  // offsets of the objects and of the ids, and the size of the whole file
+  std::uint64_t blocks = 0;
+  std::uint64_t ids = 0;
+  std::uint64_t bytes = 0;
+};
+
+// string-like ids are stored as their length and characters, other trivially copyable ids as they are
+template <typename Id>
+inline constexpr bool is_string_id_v = std::is_constructible_v<Id, std::string_view>
+  && (std::is_convertible_v<const Id &, std::string_view> || requires(const Id &id) { { id.str() } -> std::convertible_to<std::string_view>; });
+
+template <typename Id>
+inline constexpr bool is_storable_id_v = is_string_id_v<Id> || std::is_trivially_copyable_v<Id>;
+
+template <typename Id>
+void write_id(std::vector<std::byte> &out, const Id &id) {
+  auto append = [&](const void *data, std::size_t size) {
+    auto *bytes = static_cast<const std::byte *>(data);
+    out.insert(out.end(), bytes, bytes + size);
+  };
+  if constexpr (is_string_id_v<Id>) {
+    std::string_view str;
+    if constexpr (requires { id.str(); }) {
+      str = id.str();
+    } else {
+      str = id;
+    }
+    std::uint64_t size = str.size();
+    append(&size, sizeof(size));
+    append(str.data(), str.size());
+  } else {
+    append(&id, sizeof(id));
+  }
+}
+
+// consumes one id from the front of 'in'
+template <typename Id>
+Id read_id(std::span<const std::byte> &in) {
+  auto take = [&](std::size_t size) {
+    if (in.size() < size) {
+      throw std::runtime_error("mr::Manager: truncated id in file");
+    }
+    std::span<const std::byte> bytes = in.first(size);
+    in = in.subspan(size);
+    return bytes;
+  };
+  if constexpr (is_string_id_v<Id>) {
+    std::uint64_t size;
+    std::memcpy(&size, take(sizeof(size)).data(), sizeof(size));
+    std::span<const std::byte> chars = take(size);
+    return Id(std::string_view {reinterpret_cast<const char *>(chars.data()), chars.size()});
+  } else {
+    Id id;
+    std::memcpy(&id, take(sizeof(id)).data(), sizeof(id));
+    return id;
+  }
+}
+
+// bytes an id takes in the file at least, which bounds how many ids a file can hold
+template <typename Id>
+inline constexpr std::size_t min_id_bytes = is_string_id_v<Id> ? sizeof(std::uint64_t) : sizeof(Id);
+
+// whether the sections 'header' describes follow each other inside its 'bytes': the header,
+// 'count' blocks of 'block_size' from the page-aligned 'blocks', then at least 'count' ids of
+// 'min_id' bytes. Every field comes from the file, so no sum or product may wrap
+inline bool valid_layout(const FileHeader &header, std::uint64_t block_size, std::uint64_t min_id) noexcept {
+  if (header.blocks < sizeof(FileHeader) || header.blocks % file_page != 0 || header.blocks > header.bytes) {
+    return false;
+  }
+  if (header.count > (header.bytes - header.blocks) / block_size) {
+    return false;
+  }
+  std::uint64_t ids = header.blocks + header.count * block_size;
+  return header.ids == ids && header.count <= (header.bytes - ids) / min_id;
+}
+
+// writes next to 'path' first, so a failed save leaves the previous file in place
+inline void write_file(const std::filesystem::path &path, std::span<const std::span<const std::byte>> parts) {
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+  {
+    std::ofstream file {temporary, std::ios::binary | std::ios::trunc};
+    for (std::span<const std::byte> part : parts) {
+      file.write(reinterpret_cast<const char *>(part.data()), static_cast<std::streamsize>(part.size()));
+    }
+    if (!file.flush()) {
+      throw std::runtime_error("mr::Manager: can't write " + temporary.string());
+    }
+  }
+  std::filesystem::rename(temporary, path);
+}
+
+// private, writable mapping of a whole file (a page-aligned copy where mmap isn't available)
+inline std::span<std::byte> map_file(const std::filesystem::path &path) {
+#if defined(__linux__)
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "mr::Manager: can't open " + path.string());
+  }
+  struct stat info {};
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    int error = info.st_size == 0 ? EINVAL : errno;
+    close(fd);
+    throw std::system_error(error, std::generic_category(), "mr::Manager: can't map " + path.string());
+  }
+  auto size = static_cast<std::size_t>(info.st_size);
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  int error = errno;
+  close(fd);
+  if (data == MAP_FAILED) {
+    throw std::system_error(error, std::generic_category(), "mr::Manager: can't map " + path.string());
+  }
+  return {static_cast<std::byte *>(data), size};
+#else
+  std::ifstream file {path, std::ios::binary | std::ios::ate};
+  if (!file) {
+    throw std::runtime_error("mr::Manager: can't open " + path.string());
+  }
+  auto size = static_cast<std::size_t>(file.tellg());
+  auto *data = static_cast<std::byte *>(::operator new(size, std::align_val_t {file_page}));
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(size))) {
+    ::operator delete(data, std::align_val_t {file_page});
+    throw std::runtime_error("mr::Manager: can't read " + path.string());
+  }
+  return {data, size};
+#endif
+}
+
+inline void unmap_file(std::span<std::byte> file) noexcept {
+#if defined(__linux__)
+  munmap(file.data(), file.size());
+#else
+  ::operator delete(file.data(), std::align_val_t {file_page});
+#endif
+}
+} // namespace mr::detail
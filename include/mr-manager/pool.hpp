@@ -0,0 +1,732 @@
+#pragma once
+
+#include <memory_resource>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "lockfree.hpp"
+
+namespace mr {
+// fixed rather than std::hardware_destructive_interference_size, which may change between
+// compiler versions and so shouldn't shape a layout shared across translation units
+inline constexpr std::size_t cache_line = 64;
+
+// run of blocks of one arena, used to split the walk over live blocks across threads
+struct BlockRange {
+  std::byte *first;
+  std::size_t block_size;
+  const std::atomic<std::uint64_t> *live;
+  // liveness words covered, 64 blocks each
+  std::size_t begin_word;
+  std::size_t end_word;
+
+  // f(void *block) for every block marked live, in address order
+  template <typename F>
+  void for_each(F &&f) const {
+    for (std::size_t word = begin_word; word < end_word; word++) {
+      std::uint64_t bits = live[word].load(std::memory_order_acquire);
+      while (bits != 0) {
+        std::size_t block = word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+        bits &= bits - 1;
+        f(static_cast<void *>(first + block * block_size));
+      }
+    }
+  }
+};
+
+// Monotonic resource that grows by whole arenas taken from an upstream resource.
+// Arenas are never moved or merged, so objects stay where they were allocated;
+// memory is only given back on release() or destruction. The first arena is
+// requested lazily, so types that are never created cost nothing.
+// Each arena also carries a liveness bitmap with one bit per block, which the owner of
+// the blocks may maintain with set_live() so that live blocks can be walked in address order.
+// Arenas are found by address through a sorted index, so owns() and set_live() are a binary
+// search over arena_count() arenas (logarithmic in the capacity) rather than a list walk.
+// Memory holding blocks already (such as a mapped file) can be added with adopt().
+// Every allocation is aligned to at least block_align(), which may exceed alignof(std::max_align_t).
+class SlabResource : public std::pmr::memory_resource {
+public:
+  using GrowFn = std::size_t (*)(std::size_t capacity) noexcept;
+
+  SlabResource(std::size_t block_size, std::size_t block_align, std::size_t initial_capacity, GrowFn grow,
+               std::pmr::memory_resource *upstream) noexcept
+  : _block_size((block_size + block_align - 1) / block_align * block_align)
+  , _block_align(block_align)
+  , _initial_capacity(std::max<std::size_t>(initial_capacity, 1))
+  , _grow(grow)
+  , _upstream(upstream)
+  {}
+
+  ~SlabResource() noexcept override {
+    release();
+  }
+
+  SlabResource(const SlabResource &) = delete;
+  SlabResource & operator=(const SlabResource &) = delete;
+
+  void release() noexcept {
+    std::lock_guard lock {_grow_mutex};
+    for (auto *list : {&_current, &_adopted}) {
+      Arena *arena = list->exchange(nullptr, std::memory_order_acq_rel);
+      while (arena != nullptr) {
+        Arena *next = arena->next;
+        _upstream->deallocate(arena, arena->bytes, alignof(std::max_align_t));
+        arena = next;
+      }
+    }
+    ArenaIndex *index = _index.exchange(nullptr, std::memory_order_acq_rel);
+    while (index != nullptr) {
+      delete std::exchange(index, index->previous);
+    }
+    _capacity.store(0, std::memory_order_relaxed);
+    _arena_count.store(0, std::memory_order_relaxed);
+  }
+
+  // makes sure the next 'blocks' blocks can be carved out of a single arena
+  void reserve(std::size_t blocks) {
+    std::size_t bytes = blocks * _block_size;
+    Arena *arena = _current.load(std::memory_order_acquire);
+    if (arena == nullptr || arena->size - arena->used.load(std::memory_order_relaxed) < bytes) {
+      _add_arena(arena, bytes + _block_align);
+    }
+  }
+
+  // adds 'memory', whose first 'blocks' blocks hold objects already, as an arena which is
+  // full from the start: its blocks are marked live and are only reused once freed. It must
+  // be aligned to block_align() and outlive the resource, which never frees it.
+  void adopt(void *memory, std::size_t blocks) {
+    std::lock_guard lock {_grow_mutex};
+    std::unique_ptr<ArenaIndex> index = _grown_index();
+    std::size_t size = blocks * _block_size;
+    std::size_t bytes = sizeof(Arena) + _live_words(size) * sizeof(std::uint64_t);
+    void *header = _upstream->allocate(bytes, alignof(std::max_align_t));
+    auto *live = reinterpret_cast<std::atomic<std::uint64_t> *>(static_cast<std::byte *>(header) + sizeof(Arena));
+    std::uninitialized_value_construct_n(live, _live_words(size));
+    for (std::size_t word = 0; word < blocks / 64; word++) {
+      live[word].store(~std::uint64_t{0}, std::memory_order_relaxed);
+    }
+    if (blocks % 64 != 0) {
+      live[blocks / 64].store((std::uint64_t{1} << (blocks % 64)) - 1, std::memory_order_relaxed);
+    }
+    Arena *arena = new (header) Arena {_adopted.load(std::memory_order_relaxed), size, 0, live, static_cast<std::byte *>(memory), bytes};
+    arena->used.store(size, std::memory_order_relaxed);
+    _publish_index(std::move(index), arena);
+    _adopted.store(arena, std::memory_order_release);
+  }
+
+  // bytes reserved from upstream across all arenas, not counting adopted ones
+  std::size_t capacity() const noexcept {
+    return _capacity.load(std::memory_order_relaxed);
+  }
+
+  std::size_t arena_count() const noexcept {
+    return _arena_count.load(std::memory_order_relaxed);
+  }
+
+  std::pmr::memory_resource * upstream() const noexcept {
+    return _upstream;
+  }
+
+  // stride of one object, a multiple of block_align()
+  std::size_t block_size() const noexcept {
+    return _block_size;
+  }
+
+  std::size_t block_align() const noexcept {
+    return _block_align;
+  }
+
+  // blocks in the first arena
+  std::size_t initial_capacity() const noexcept {
+    return _initial_capacity;
+  }
+
+  GrowFn grow() const noexcept {
+    return _grow;
+  }
+
+  // whether 'ptr' points into one of the arenas
+  bool owns(const void *ptr) const noexcept {
+    return _find_arena(ptr) != nullptr;
+  }
+
+  // marks a block_size() block of one of the arenas as holding an object or not
+  void set_live(const void *block, bool live) noexcept {
+    if (Arena *arena = _find_arena(block)) {
+      std::size_t index = static_cast<std::size_t>(static_cast<const std::byte *>(block) - arena->first()) / _block_size;
+      std::uint64_t bit = std::uint64_t{1} << (index % 64);
+      if (live) {
+        arena->live[index / 64].fetch_or(bit, std::memory_order_release);
+      } else {
+        arena->live[index / 64].fetch_and(~bit, std::memory_order_release);
+      }
+    }
+  }
+
+  // the blocks of every arena, in ranges of about 'blocks' blocks (rounded up to 64),
+  // or one range per arena for 0
+  std::vector<BlockRange> live_ranges(std::size_t blocks = 0) const {
+    std::vector<BlockRange> ranges;
+    for (const auto *list : {&_current, &_adopted}) {
+      for (Arena *arena = list->load(std::memory_order_acquire); arena != nullptr; arena = arena->next) {
+        std::size_t end = _live_words(arena->size);
+        std::size_t words = blocks == 0 ? std::max<std::size_t>(end, 1) : (blocks + 63) / 64;
+        for (std::size_t word = 0; word < end; word += words) {
+          ranges.push_back({arena->first(), _block_size, arena->live, word, std::min(word + words, end)});
+        }
+      }
+    }
+    return ranges;
+  }
+
+protected:
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override {
+    // blocks are found again by their index from first(), so none may start off the stride
+    alignment = std::max(alignment, _block_align);
+    Arena *arena = _current.load(std::memory_order_acquire);
+    while (true) {
+      if (arena != nullptr) {
+        if (void *ptr = arena->allocate(bytes, alignment)) [[likely]] {
+          return ptr;
+        }
+      }
+      arena = _add_arena(arena, bytes + alignment);
+    }
+  }
+
+  void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  struct alignas(std::max_align_t) Arena {
+    Arena *next;
+    std::size_t size;
+    // offset of the first block, past the padding aligning it
+    std::size_t first_offset;
+    // one bit per block, stored after the blocks
+    std::atomic<std::uint64_t> *live;
+    // right after the header, unless the arena was adopted
+    std::byte *base;
+    // taken from upstream for the arena (or for the header and bitmap of an adopted one)
+    std::size_t bytes;
+    std::atomic<std::size_t> used {0};
+
+    std::byte * data() noexcept {
+      return base;
+    }
+    const std::byte * data() const noexcept {
+      return base;
+    }
+
+    // blocks are carved out back to back, so the first one fixes the stride of all of them
+    std::byte * first() noexcept {
+      return data() + first_offset;
+    }
+
+    void * allocate(std::size_t bytes, std::size_t alignment) noexcept {
+      auto base = reinterpret_cast<std::uintptr_t>(data());
+      std::size_t offset = used.load(std::memory_order_relaxed);
+      std::size_t begin, end;
+      do {
+        begin = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+        end = begin + bytes;
+        if (end > size) {
+          return nullptr;
+        }
+      } while (!used.compare_exchange_weak(offset, end, std::memory_order_relaxed));
+      return data() + begin;
+    }
+  };
+
+  // every arena by address, replaced whole when one is added so that lookups take no lock.
+  // Replaced indexes may still be read, so they are only freed by release()
+  struct ArenaIndex {
+    std::vector<Arena *> arenas;
+    ArenaIndex *previous;
+  };
+
+  // the last arena starting at or before 'ptr', if 'ptr' is inside it
+  Arena * _find_arena(const void *ptr) const noexcept {
+    const ArenaIndex *index = _index.load(std::memory_order_acquire);
+    if (index == nullptr) {
+      return nullptr;
+    }
+    auto *byte = static_cast<const std::byte *>(ptr);
+    auto it = std::ranges::upper_bound(index->arenas, byte, std::less {}, [](const Arena *arena) { return arena->data(); });
+    if (it == index->arenas.begin()) {
+      return nullptr;
+    }
+    Arena *arena = *std::prev(it);
+    return byte < arena->data() + arena->size ? arena : nullptr;
+  }
+
+  // a copy of the index with room for one more arena, taken with _grow_mutex held before
+  // the arena is allocated, so that publishing it can't fail
+  std::unique_ptr<ArenaIndex> _grown_index() const {
+    ArenaIndex *previous = _index.load(std::memory_order_relaxed);
+    auto index = std::make_unique<ArenaIndex>();
+    index->arenas.reserve((previous == nullptr ? 0 : previous->arenas.size()) + 1);
+    if (previous != nullptr) {
+      index->arenas = previous->arenas;
+    }
+    index->previous = previous;
+    return index;
+  }
+
+  void _publish_index(std::unique_ptr<ArenaIndex> index, Arena *arena) noexcept {
+    auto by_address = [](const Arena *other) { return other->data(); };
+    index->arenas.insert(std::ranges::upper_bound(index->arenas, arena->data(), std::less {}, by_address), arena);
+    _index.store(index.release(), std::memory_order_release);
+  }
+
+  std::size_t _live_words(std::size_t size) const noexcept {
+    return (size / _block_size + 63) / 64;
+  }
+
+  static std::size_t _live_offset(std::size_t size) noexcept {
+    return (size + alignof(std::uint64_t) - 1) / alignof(std::uint64_t) * alignof(std::uint64_t);
+  }
+
+  std::size_t _arena_bytes(std::size_t size) const noexcept {
+    return sizeof(Arena) + _live_offset(size) + _live_words(size) * sizeof(std::uint64_t);
+  }
+
+  // appends an arena unless another thread already replaced 'seen'
+  Arena * _add_arena(Arena *seen, std::size_t min_size) {
+    std::lock_guard lock {_grow_mutex};
+    Arena *current = _current.load(std::memory_order_acquire);
+    if (current != seen) {
+      return current;
+    }
+    std::unique_ptr<ArenaIndex> index = _grown_index();
+    std::size_t capacity = current == nullptr ? _initial_capacity : _grow(current->size / _block_size);
+    std::size_t size = std::max(std::max<std::size_t>(capacity, 1) * _block_size, min_size);
+    // upstream only aligns to max_align_t, so room for the padding before the first block
+    if (_block_align > alignof(std::max_align_t)) {
+      size += _block_align - alignof(std::max_align_t);
+    }
+
+    void *memory = _upstream->allocate(_arena_bytes(size), alignof(std::max_align_t));
+    auto *data = static_cast<std::byte *>(memory) + sizeof(Arena);
+    auto base = reinterpret_cast<std::uintptr_t>(data);
+    std::size_t first_offset = ((base + _block_align - 1) & ~(_block_align - 1)) - base;
+    auto *live = reinterpret_cast<std::atomic<std::uint64_t> *>(data + _live_offset(size));
+    std::uninitialized_value_construct_n(live, _live_words(size));
+    Arena *arena = new (memory) Arena {current, size, first_offset, live, data, _arena_bytes(size)};
+    _capacity.fetch_add(size, std::memory_order_relaxed);
+    _arena_count.fetch_add(1, std::memory_order_relaxed);
+    // indexed first, so blocks of the arena are found as soon as they can be allocated
+    _publish_index(std::move(index), arena);
+    _current.store(arena, std::memory_order_release);
+    return arena;
+  }
+
+  std::size_t _block_size;
+  std::size_t _block_align;
+  std::size_t _initial_capacity;
+  GrowFn _grow;
+  std::pmr::memory_resource *_upstream;
+
+  std::atomic<Arena *> _current {nullptr};
+  std::atomic<Arena *> _adopted {nullptr};
+  std::atomic<ArenaIndex *> _index {nullptr};
+  std::mutex _grow_mutex;
+  std::atomic<std::size_t> _capacity {0};
+  std::atomic<std::size_t> _arena_count {0};
+};
+
+// Fixed-size block resource layered over a SlabResource. Each thread keeps two
+// magazines of free blocks (Bonwick-style) so allocate/deallocate are plain
+// array pushes and pops; full and empty magazines are exchanged through
+// lock-free depots. Blocks are never returned to the slab, only recycled.
+// The thread-local magazines are keyed by Tag, so there must be at most one
+// live instance per Tag at a time.
+template <typename Tag>
+class MagazineResource : public std::pmr::memory_resource {
+public:
+  static inline constexpr std::size_t magazine_size = 64;
+
+  explicit MagazineResource(SlabResource *upstream) noexcept
+  : _upstream(upstream)
+  {}
+
+  // detaches the magazines of threads that are still running
+  ~MagazineResource() noexcept override {
+    std::lock_guard lock {_caches_mutex};
+    for (Cache *cache : _caches) {
+      *cache = {};
+    }
+  }
+
+  MagazineResource(const MagazineResource &) = delete;
+  MagazineResource & operator=(const MagazineResource &) = delete;
+
+  SlabResource * upstream() const noexcept {
+    return _upstream;
+  }
+
+protected:
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (!_fits(bytes, alignment)) [[unlikely]] {
+      return _upstream->allocate(bytes, alignment);
+    }
+
+    Cache &cache = _local();
+    if (cache.loaded->count == 0) [[unlikely]] {
+      if (cache.previous->count != 0) {
+        std::swap(cache.loaded, cache.previous);
+      } else if (Magazine *full = _pop(_full)) {
+        _push(_empty, cache.previous);
+        cache.previous = cache.loaded;
+        cache.loaded = full;
+      } else {
+        return _upstream->allocate(_upstream->block_size(), _upstream->block_align());
+      }
+    }
+    return cache.loaded->blocks[--cache.loaded->count];
+  }
+
+  void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override {
+    if (!_fits(bytes, alignment)) [[unlikely]] {
+      return;
+    }
+
+    Cache &cache = _local();
+    if (cache.loaded->count == magazine_size) [[unlikely]] {
+      if (cache.previous->count == 0) {
+        std::swap(cache.loaded, cache.previous);
+      } else {
+        Magazine *empty = _pop(_empty);
+        _push(_full, cache.previous);
+        cache.previous = cache.loaded;
+        cache.loaded = empty != nullptr ? empty : _make_magazine();
+      }
+    }
+    cache.loaded->blocks[cache.loaded->count++] = ptr;
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  struct Magazine {
+    std::uint32_t index = 0;
+    std::atomic<std::uint32_t> next {detail::invalid_index};
+    std::size_t count = 0;
+    void *blocks[magazine_size];
+  };
+
+  struct Cache {
+    MagazineResource *owner = nullptr;
+    Magazine *loaded = nullptr;
+    Magazine *previous = nullptr;
+
+    // hands the magazines of an exiting thread over to the depots
+    ~Cache() noexcept {
+      if (owner == nullptr) {
+        return;
+      }
+      std::lock_guard lock {owner->_caches_mutex};
+      std::erase(owner->_caches, this);
+      for (Magazine *magazine : {loaded, previous}) {
+        owner->_push(magazine->count == 0 ? owner->_empty : owner->_full, magazine);
+      }
+    }
+  };
+
+  bool _fits(std::size_t bytes, std::size_t alignment) const noexcept {
+    return bytes <= _upstream->block_size() && alignment <= _upstream->block_align();
+  }
+
+  Cache & _local() noexcept {
+    thread_local Cache cache;
+    if (cache.owner == nullptr) [[unlikely]] {
+      cache.owner = this;
+      cache.loaded = _make_magazine();
+      cache.previous = _make_magazine();
+      std::lock_guard lock {_caches_mutex};
+      _caches.push_back(&cache);
+    }
+    return cache;
+  }
+
+  Magazine * _make_magazine() noexcept {
+    if (Magazine *empty = _pop(_empty)) {
+      return empty;
+    }
+    std::uint32_t index = _magazine_count.fetch_add(1, std::memory_order_relaxed);
+    Magazine &magazine = _magazines.ensure(index);
+    magazine.index = index;
+    return &magazine;
+  }
+
+  void _push(detail::IndexStack &depot, Magazine *magazine) noexcept {
+    depot.push(magazine->index, [this](std::uint32_t i) -> auto & { return _magazines.find(i)->next; });
+  }
+
+  Magazine * _pop(detail::IndexStack &depot) noexcept {
+    std::uint32_t index = depot.pop([this](std::uint32_t i) -> auto & { return _magazines.find(i)->next; });
+    return index == detail::invalid_index ? nullptr : _magazines.find(index);
+  }
+
+  SlabResource *_upstream;
+  detail::SegmentedArray<Magazine, 4> _magazines;
+  std::atomic<std::uint32_t> _magazine_count {0};
+  detail::IndexStack _full;
+  detail::IndexStack _empty;
+
+  std::mutex _caches_mutex;
+  std::vector<Cache *> _caches;
+};
+
+namespace detail {
+// NUMA node of the calling thread, looked up once per thread
+inline std::size_t numa_node() noexcept {
+#if defined(__linux__)
+  thread_local std::size_t node = [] {
+    unsigned cpu = 0, node = 0;
+    return syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? std::size_t{node} : 0;
+  }();
+  return node;
+#else
+  return 0;
+#endif
+}
+} // namespace detail
+
+// Upstream resource whose pages are preferably placed on one NUMA node. Memory is
+// mapped directly, so it is meant for arenas rather than small allocations; where
+// NUMA placement isn't supported it forwards to 'fallback'.
+class NumaNodeResource : public std::pmr::memory_resource {
+public:
+  explicit NumaNodeResource(std::size_t node, std::pmr::memory_resource *fallback = std::pmr::new_delete_resource()) noexcept
+  : _node(node)
+  , _fallback(fallback)
+  {}
+
+  std::size_t node() const noexcept {
+    return _node;
+  }
+
+protected:
+  void * do_allocate(std::size_t bytes, [[maybe_unused]] std::size_t alignment) override {
+#if defined(__linux__)
+    void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    // a preference, not a binding: a full node falls back to the others instead of failing
+    unsigned long mask = 1ul << (_node % (sizeof(mask) * 8));
+    syscall(SYS_mbind, ptr, bytes, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0);
+    return ptr;
+#else
+    return _fallback->allocate(bytes, alignment);
+#endif
+  }
+
+  void do_deallocate(void *ptr, std::size_t bytes, [[maybe_unused]] std::size_t alignment) override {
+#if defined(__linux__)
+    munmap(ptr, bytes);
+#else
+    _fallback->deallocate(ptr, bytes, alignment);
+#endif
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  std::size_t _node;
+  [[maybe_unused]] std::pmr::memory_resource *_fallback;
+};
+
+// Upstream resource backing arenas with 2 MiB pages, so walking or randomly reading a large
+// pool takes far fewer TLB misses. Sizes are rounded up to whole huge pages, which makes
+// it a fit for types with large arenas only. Reserved huge pages (MAP_HUGETLB) are used when
+// there are any, otherwise regular pages with a transparent huge page hint, which the kernel
+// may or may not follow. Alignments up to the base page size are supported.
+// Plug it in with
+//   template <> struct mr::AssetPool<Particle> : mr::DefaultAssetPool {
+//     static std::pmr::memory_resource * upstream() noexcept {
+//       static mr::HugePageResource resource;
+//       return &resource;
+//     }
+//   };
+class HugePageResource : public std::pmr::memory_resource {
+public:
+  static inline constexpr std::size_t page_size = std::size_t{2} << 20;
+
+  explicit HugePageResource(std::pmr::memory_resource *fallback = std::pmr::new_delete_resource()) noexcept
+  : _fallback(fallback)
+  {}
+
+protected:
+  void * do_allocate(std::size_t bytes, [[maybe_unused]] std::size_t alignment) override {
+#if defined(__linux__)
+    std::size_t size = _rounded(bytes);
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+    if (ptr == MAP_FAILED) {
+      ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ptr == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      madvise(ptr, size, MADV_HUGEPAGE);
+    }
+    return ptr;
+#else
+    return _fallback->allocate(bytes, alignment);
+#endif
+  }
+
+  void do_deallocate(void *ptr, std::size_t bytes, [[maybe_unused]] std::size_t alignment) override {
+#if defined(__linux__)
+    munmap(ptr, _rounded(bytes));
+#else
+    _fallback->deallocate(ptr, bytes, alignment);
+#endif
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  static constexpr std::size_t _rounded(std::size_t bytes) noexcept {
+    return (std::max<std::size_t>(bytes, 1) + page_size - 1) / page_size * page_size;
+  }
+
+  [[maybe_unused]] std::pmr::memory_resource *_fallback;
+};
+
+// Block resource with one SlabResource and MagazineResource per NUMA node (nodes past
+// Nodes wrap around). Threads allocate from the pool of the node they run on, and freed
+// blocks go back to the pool they came from, so objects stay on the node of the thread that
+// created them. The slab passed in only supplies the block layout, the growth policy and
+// the upstream used where NUMA placement isn't supported.
+// Plug it in with
+//   template <> struct mr::AssetPool<Mesh> : mr::DefaultAssetPool {
+//     template <typename T> using resource = mr::NumaResource<T, 2>;
+//   };
+template <typename Tag, std::size_t Nodes>
+class NumaResource : public std::pmr::memory_resource {
+public:
+  explicit NumaResource(SlabResource *layout) noexcept
+  : NumaResource(layout, std::make_index_sequence<Nodes> {})
+  {}
+
+  NumaResource(const NumaResource &) = delete;
+  NumaResource & operator=(const NumaResource &) = delete;
+
+  // grows the calling thread's node for 'blocks' more blocks
+  void reserve(std::size_t blocks) {
+    _slabs[_local()].reserve(blocks);
+  }
+
+  std::size_t capacity() const noexcept {
+    std::size_t total = 0;
+    for (const SlabResource &slab : _slabs) {
+      total += slab.capacity();
+    }
+    return total;
+  }
+
+  std::size_t arena_count() const noexcept {
+    std::size_t total = 0;
+    for (const SlabResource &slab : _slabs) {
+      total += slab.arena_count();
+    }
+    return total;
+  }
+
+  const SlabResource & node(std::size_t index) const noexcept {
+    return _slabs[index];
+  }
+
+  // each node ignores blocks of the others, so this is one arena lookup per node
+  void set_live(const void *block, bool live) noexcept {
+    for (SlabResource &slab : _slabs) {
+      slab.set_live(block, live);
+    }
+  }
+
+  std::vector<BlockRange> live_ranges(std::size_t blocks = 0) const {
+    std::vector<BlockRange> ranges;
+    for (const SlabResource &slab : _slabs) {
+      std::ranges::copy(slab.live_ranges(blocks), std::back_inserter(ranges));
+    }
+    return ranges;
+  }
+
+protected:
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override {
+    return _magazines[_local()]->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override {
+    std::size_t local = _local();
+    for (std::size_t i = 0; i < Nodes; i++) {
+      // the local node first: most objects are freed where they were created
+      std::size_t node = (local + i) % Nodes;
+      if (_slabs[node].owns(ptr)) {
+        _magazines[node]->deallocate(ptr, bytes, alignment);
+        return;
+      }
+    }
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  // per-node magazines need their own thread-local caches
+  template <std::size_t Node> struct NodeTag {};
+
+  template <std::size_t ...Node>
+  NumaResource(SlabResource *layout, std::index_sequence<Node...>) noexcept
+  : _upstreams {NumaNodeResource {Node, layout->upstream()}...}
+  , _slabs {SlabResource {layout->block_size(), layout->block_align(), layout->initial_capacity(), layout->grow(), &_upstreams[Node]}...}
+  , _magazine_resources {&_slabs[Node]...}
+  , _magazines {&std::get<Node>(_magazine_resources)...}
+  {}
+
+  static std::size_t _local() noexcept {
+    return detail::numa_node() % Nodes;
+  }
+
+  template <typename> struct Magazines;
+  template <std::size_t ...Node> struct Magazines<std::index_sequence<Node...>> {
+    using type = std::tuple<MagazineResource<NodeTag<Node>>...>;
+  };
+
+  std::array<NumaNodeResource, Nodes> _upstreams;
+  std::array<SlabResource, Nodes> _slabs;
+  typename Magazines<std::make_index_sequence<Nodes>>::type _magazine_resources;
+  std::array<std::pmr::memory_resource *, Nodes> _magazines;
+};
+
+} // namespace mr
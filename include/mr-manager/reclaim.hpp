@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace mr {
+// Per-thread batches of retired objects which are only destroyed, in bulk, by
+// collect() on whichever thread calls it. retire() touches nothing but the
+// calling thread's batch (its lock is only ever contended by a concurrent
+// collect). Each collect() closes an epoch: everything retired before it
+// started is destroyed, objects retired concurrently are left for the next one.
+// Batches are keyed by Tag, so there must be at most one live instance per Tag.
+template <typename T, typename Tag = T>
+class RetireQueue {
+public:
+  using Deleter = void (*)(T *) noexcept;
+
+  explicit RetireQueue(Deleter deleter) noexcept
+  : _deleter(deleter)
+  {}
+
+  // objects which were never collected are leaked, their memory may already be gone
+  ~RetireQueue() noexcept {
+    std::lock_guard lock {_batches_mutex};
+    for (Batch *batch : _batches) {
+      batch->owner = nullptr;
+    }
+  }
+
+  RetireQueue(const RetireQueue &) = delete;
+  RetireQueue & operator=(const RetireQueue &) = delete;
+
+  void retire(T *ptr) noexcept {
+    Batch &batch = _local();
+    {
+      std::lock_guard lock {batch.mutex};
+      batch.items.push_back(ptr);
+    }
+    _pending.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // returns the number of destroyed objects
+  std::size_t collect() noexcept {
+    std::vector<T *> items;
+    {
+      std::lock_guard lock {_batches_mutex};
+      _epoch.fetch_add(1, std::memory_order_relaxed);
+      for (Batch *batch : _batches) {
+        std::lock_guard batch_lock {batch->mutex};
+        items.insert(items.end(), batch->items.begin(), batch->items.end());
+        batch->items.clear();
+      }
+      items.insert(items.end(), _orphans.begin(), _orphans.end());
+      _orphans.clear();
+    }
+    for (T *ptr : items) {
+      _deleter(ptr);
+    }
+    _pending.fetch_sub(items.size(), std::memory_order_relaxed);
+    return items.size();
+  }
+
+  // objects retired but not collected yet
+  std::size_t pending() const noexcept {
+    return _pending.load(std::memory_order_relaxed);
+  }
+
+  // number of completed collect() calls
+  std::size_t epoch() const noexcept {
+    return _epoch.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Batch {
+    RetireQueue *owner = nullptr;
+    std::mutex mutex;
+    std::vector<T *> items;
+
+    // objects retired by an exiting thread are handed to the next collect()
+    ~Batch() noexcept {
+      if (owner == nullptr) {
+        return;
+      }
+      std::lock_guard lock {owner->_batches_mutex};
+      std::erase(owner->_batches, this);
+      owner->_orphans.insert(owner->_orphans.end(), items.begin(), items.end());
+    }
+  };
+
+  Batch & _local() noexcept {
+    thread_local Batch batch;
+    if (batch.owner == nullptr) [[unlikely]] {
+      batch.owner = this;
+      std::lock_guard lock {_batches_mutex};
+      _batches.push_back(&batch);
+    }
+    return batch;
+  }
+
+  Deleter _deleter;
+  std::atomic<std::size_t> _pending {0};
+  std::atomic<std::size_t> _epoch {0};
+
+  std::mutex _batches_mutex;
+  std::vector<Batch *> _batches;
+  std::vector<T *> _orphans;
+};
+
+} // namespace mr
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <typeinfo>
+#include <vector>
+
+#include "stats.hpp"
+#include "trace.hpp"
+
+namespace mr {
+// type-erased entry points of one Manager<T>
+struct ManagerInfo {
+  const std::type_info *type;
+  ManagerStats (*stats)() noexcept;
+  // bytes of the pool blocks held by objects which aren't destroyed yet
+  std::size_t (*memory)() noexcept;
+  void (*clear)() noexcept;
+  // evicts named entries until about 'bytes' are released, returns the bytes released
+  std::size_t (*trim)(std::size_t bytes) noexcept;
+  // sampled latencies per TraceOp, all zero unless MR_MANAGER_ENABLE_TRACING is set
+  LatencyHistograms (*latencies)() noexcept;
+};
+
+// process-wide list of the Manager<T> singletons, which add themselves on construction
+class Registry {
+public:
+  static Registry & get() noexcept {
+    static Registry *registry = new Registry;
+    return *registry;
+  }
+
+  void add(const ManagerInfo &info) {
+    std::lock_guard lock {_mutex};
+    _managers.push_back(info);
+  }
+
+  void remove(const std::type_info &type) noexcept {
+    std::lock_guard lock {_mutex};
+    std::erase_if(_managers, [&](const ManagerInfo &info) { return *info.type == type; });
+  }
+
+  // f(const ManagerInfo &) is called with the registry locked, so it must not create managers
+  template <typename F>
+  void for_each(F &&f) const {
+    std::lock_guard lock {_mutex};
+    for (const ManagerInfo &info : _managers) {
+      f(info);
+    }
+  }
+
+  std::size_t size() const noexcept {
+    std::lock_guard lock {_mutex};
+    return _managers.size();
+  }
+
+  std::size_t memory() const noexcept {
+    std::lock_guard lock {_mutex};
+    return _memory();
+  }
+
+  void clear() noexcept {
+    std::lock_guard lock {_mutex};
+    for (const ManagerInfo &info : _managers) {
+      info.clear();
+    }
+  }
+
+  // evicts from the types using the most memory first until memory() is at most 'target'
+  // (or nothing evictable is left); returns the bytes released
+  std::size_t trim(std::size_t target) noexcept {
+    std::lock_guard lock {_mutex};
+    return _trim(target);
+  }
+
+  // process-wide limit for memory(), 0 for none; enforced whenever a pool grows
+  void set_budget(std::size_t bytes) noexcept {
+    _budget.store(bytes, std::memory_order_relaxed);
+  }
+
+  std::size_t budget() const noexcept {
+    return _budget.load(std::memory_order_relaxed);
+  }
+
+  // trims down to budget() if it is exceeded; skipped while another thread trims
+  void enforce() noexcept {
+    std::size_t budget = _budget.load(std::memory_order_relaxed);
+    if (budget == 0) {
+      return;
+    }
+    std::unique_lock lock {_mutex, std::try_to_lock};
+    if (lock.owns_lock() && _memory() > budget) {
+      _trim(budget);
+    }
+  }
+
+private:
+  Registry() = default;
+
+  std::size_t _memory() const noexcept {
+    std::size_t total = 0;
+    for (const ManagerInfo &info : _managers) {
+      total += info.memory();
+    }
+    return total;
+  }
+
+  std::size_t _trim(std::size_t target) noexcept {
+    std::vector<std::pair<std::size_t, const ManagerInfo *>> usage;
+    std::size_t total = 0;
+    for (const ManagerInfo &info : _managers) {
+      usage.emplace_back(info.memory(), &info);
+      total += usage.back().first;
+    }
+    std::ranges::sort(usage, std::greater {}, &std::pair<std::size_t, const ManagerInfo *>::first);
+
+    std::size_t released = 0;
+    for (auto [memory, info] : usage) {
+      if (total - released <= target) {
+        break;
+      }
+      released += info->trim(std::min(memory, total - released - target));
+    }
+    return released;
+  }
+
+  mutable std::mutex _mutex;
+  std::vector<ManagerInfo> _managers;
+  std::atomic<std::size_t> _budget {0};
+};
+
+} // namespace mr
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "lockfree.hpp"
+
+namespace mr {
+struct SlotId {
+  static inline constexpr std::uint32_t invalid_index = detail::invalid_index;
+
+  std::uint32_t index = invalid_index;
+  std::uint32_t generation = 0;
+
+  constexpr bool operator==(const SlotId &) const noexcept = default;
+  constexpr explicit operator bool() const noexcept { return index != invalid_index; }
+};
+
+// Dense, integer-indexed table of T* addressed by generation-tagged ids.
+// Slots live in segments of doubling size which are never moved, so lookups
+// are a shift, a bit_width and two loads. Released slots are recycled through
+// a lock-free free list; bumping the generation on release invalidates stale ids.
+template <typename T>
+struct SlotTable {
+  constexpr SlotTable() noexcept = default;
+
+  SlotTable(const SlotTable &) = delete;
+  SlotTable & operator=(const SlotTable &) = delete;
+
+  constexpr SlotId insert(T *ptr) noexcept {
+    std::uint32_t index = _pop_free();
+    if (index == SlotId::invalid_index) {
+      index = _next.fetch_add(1, std::memory_order_relaxed);
+    }
+    Slot &slot = _slots.ensure(index);
+    slot.ptr.store(ptr, std::memory_order_release);
+    _size.fetch_add(1, std::memory_order_relaxed);
+    return {index, slot.generation.load(std::memory_order_relaxed)};
+  }
+
+  constexpr T * find(SlotId id) const noexcept {
+    const Slot *slot = _find_slot(id.index);
+    if (slot == nullptr || slot->generation.load(std::memory_order_acquire) != id.generation) [[unlikely]] {
+      return nullptr;
+    }
+    T *ptr = slot->ptr.load(std::memory_order_acquire);
+    if (slot->generation.load(std::memory_order_relaxed) != id.generation) [[unlikely]] {
+      return nullptr;
+    }
+    return ptr;
+  }
+
+  // returns the released pointer, nullptr if 'id' is stale
+  constexpr T * erase(SlotId id) noexcept {
+    Slot *slot = _find_slot(id.index);
+    if (slot == nullptr) [[unlikely]] {
+      return nullptr;
+    }
+    std::uint32_t expected = id.generation;
+    if (!slot->generation.compare_exchange_strong(expected, expected + 1, std::memory_order_acq_rel)) {
+      return nullptr;
+    }
+    T *ptr = slot->ptr.exchange(nullptr, std::memory_order_acq_rel);
+    _push_free(id.index);
+    _size.fetch_sub(1, std::memory_order_relaxed);
+    return ptr;
+  }
+
+  // calls f(SlotId, T *) for every slot that is live when visited
+  template <typename F>
+  constexpr void for_each(F &&f) const noexcept {
+    std::uint32_t end = _next.load(std::memory_order_acquire);
+    for (std::uint32_t i = 0; i < end; i++) {
+      const Slot *slot = _find_slot(i);
+      if (slot == nullptr) {
+        continue;
+      }
+      SlotId id {i, slot->generation.load(std::memory_order_acquire)};
+      if (T *ptr = find(id)) {
+        f(id, ptr);
+      }
+    }
+  }
+
+  // erases every live slot, handing each pointer to 'release'
+  template <typename F>
+  constexpr void clear(F &&release) noexcept {
+    for_each([&](SlotId id, T *) {
+      if (T *ptr = erase(id)) {
+        release(ptr);
+      }
+    });
+  }
+
+  constexpr std::size_t size() const noexcept {
+    return _size.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Slot {
+    std::atomic<T *> ptr {nullptr};
+    std::atomic<std::uint32_t> generation {0};
+    std::atomic<std::uint32_t> next_free {SlotId::invalid_index};
+  };
+
+  constexpr const Slot * _find_slot(std::uint32_t index) const noexcept {
+    return _slots.find(index);
+  }
+  constexpr Slot * _find_slot(std::uint32_t index) noexcept {
+    return _slots.find(index);
+  }
+
+  constexpr void _push_free(std::uint32_t index) noexcept {
+    _free.push(index, [this](std::uint32_t i) -> auto & { return _slots.find(i)->next_free; });
+  }
+
+  constexpr std::uint32_t _pop_free() noexcept {
+    return _free.pop([this](std::uint32_t i) -> auto & { return _slots.find(i)->next_free; });
+  }
+
+  detail::SegmentedArray<Slot> _slots;
+  detail::IndexStack _free;
+  std::atomic<std::uint32_t> _next {0};
+  std::atomic<std::size_t> _size {0};
+};
+
+} // namespace mr
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace mr {
+namespace detail {
+// read prefetch into all cache levels; a no-op where the compiler has no builtin for it
+inline void prefetch([[maybe_unused]] const void *ptr) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(ptr, 0, 3);
+#endif
+}
+} // namespace detail
+
+// Immutable open-addressing table from ids to objects: built once, then only read.
+// Linear probing over a power-of-two array kept at most half full, so a lookup is
+// usually a single slot. Lookups accept any key the hash and equality accept.
+template <typename Id, typename V, typename Hash, typename Equal>
+class SnapshotTable {
+public:
+  // ids must be unique
+  explicit SnapshotTable(std::span<const std::pair<Id, V *>> items)
+  : _mask(std::bit_ceil(std::max<std::size_t>(items.size() * 2, 2)) - 1)
+  , _slots(_mask + 1)
+  , _size(items.size())
+  {
+    for (const auto &[id, value] : items) {
+      std::size_t hash = Hash {}(id);
+      std::size_t i = hash & _mask;
+      while (_slots[i].value != nullptr) {
+        i = (i + 1) & _mask;
+      }
+      _slots[i] = {hash, id, value};
+    }
+  }
+
+  template <typename K>
+  V * find(const K &id) const noexcept {
+    return _probe(Hash {}(id), id);
+  }
+
+  // pulls the first slot a lookup of 'id' probes into cache
+  template <typename K>
+  void prefetch(const K &id) const noexcept {
+    detail::prefetch(&_slots[Hash {}(id) & _mask]);
+  }
+
+  // out[i] = find(ids[i]), in groups whose slots are all prefetched before the first is
+  // probed, so their cache misses overlap; the objects found are prefetched as well.
+  // Returns the number of hits
+  template <typename K>
+  std::size_t find_batch(std::span<const K> ids, std::span<const V *> out) const noexcept {
+    static constexpr std::size_t group = 8;
+    std::array<std::size_t, group> hashes;
+    std::size_t found = 0;
+    for (std::size_t begin = 0; begin < ids.size(); begin += group) {
+      std::size_t end = std::min(begin + group, ids.size());
+      for (std::size_t i = begin; i < end; i++) {
+        hashes[i - begin] = Hash {}(ids[i]);
+        detail::prefetch(&_slots[hashes[i - begin] & _mask]);
+      }
+      for (std::size_t i = begin; i < end; i++) {
+        out[i] = _probe(hashes[i - begin], ids[i]);
+        if (out[i] != nullptr) {
+          detail::prefetch(out[i]);
+          found++;
+        }
+      }
+    }
+    return found;
+  }
+
+  // f(V *) for every object
+  template <typename F>
+  void for_each(F &&f) const {
+    for (const Slot &slot : _slots) {
+      if (slot.value != nullptr) {
+        f(slot.value);
+      }
+    }
+  }
+
+  std::size_t size() const noexcept {
+    return _size;
+  }
+
+private:
+  template <typename K>
+  V * _probe(std::size_t hash, const K &id) const noexcept {
+    for (std::size_t i = hash & _mask;; i = (i + 1) & _mask) {
+      const Slot &slot = _slots[i];
+      if (slot.value == nullptr) {
+        return nullptr;
+      }
+      if (slot.hash == hash && Equal {}(slot.id, id)) {
+        return slot.value;
+      }
+    }
+  }
+
+  struct Slot {
+    std::size_t hash = 0;
+    Id id {};
+    V *value = nullptr;
+  };
+
+  std::size_t _mask;
+  std::vector<Slot> _slots;
+  std::size_t _size;
+};
+
+} // namespace mr
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// counters cost one thread-local increment when enabled and nothing otherwise
+#ifndef MR_MANAGER_ENABLE_STATS
+#define MR_MANAGER_ENABLE_STATS 0
+#endif
+
+#include <folly/ThreadCachedInt.h>
+
+namespace mr {
+// snapshot returned by Manager<T>::stats(). The counters stay 0 unless MR_MANAGER_ENABLE_STATS
+// is set, except creates and destroyed, which Manager<T>::memory() is derived from; the rest
+// is always filled
+struct ManagerStats {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  // objects constructed by create(), try_emplace() or insert_or_assign(), named or not
+  std::uint64_t creates = 0;
+  // creates which replaced an existing entry
+  std::uint64_t overwrites = 0;
+  std::uint64_t erases = 0;
+  // entries removed by the budget sweep or by the release of their last SharedHandle
+  std::uint64_t evictions = 0;
+  std::uint64_t destroyed = 0;
+
+  std::size_t entries = 0;
+  std::size_t bytes_in_use = 0;
+  // bytes of the arenas allocated from upstream; more than one arena means the
+  // AssetPool<T>::initial_capacity was exceeded
+  std::size_t pool_capacity = 0;
+  std::size_t pool_arenas = 0;
+  // removed or replaced objects which aren't destroyed yet: entries waiting for hazard
+  // pointer reclamation and objects waiting for collect()
+  std::size_t unreclaimed = 0;
+};
+
+namespace detail {
+#if MR_MANAGER_ENABLE_STATS
+using StatCounter = folly::ThreadCachedInt<std::uint64_t>;
+#else
+struct StatCounter {
+  constexpr void increment(std::uint64_t = 1) noexcept {}
+  constexpr std::uint64_t readFull() const noexcept {
+    return 0;
+  }
+};
+#endif
+
+// counts pool blocks taken and given back, so it is kept whether or not stats are enabled
+using BlockCounter = folly::ThreadCachedInt<std::uint64_t>;
+
+struct StatCounters {
+  StatCounter hits;
+  StatCounter misses;
+  BlockCounter creates;
+  StatCounter overwrites;
+  StatCounter erases;
+  StatCounter evictions;
+  BlockCounter destroyed;
+};
+} // namespace detail
+} // namespace mr
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+// tracing costs nothing unless enabled. Enabled, Manager<T> operations fire the USDT probes
+// mr_manager:<op> and mr_manager:<op>_done (where <sys/sdt.h> is available), open a Tracy
+// zone (if TRACY_ENABLE is set), and record one call in MR_MANAGER_TRACE_SAMPLE of each
+// operation on each thread in per-type latency histograms.
+#ifndef MR_MANAGER_ENABLE_TRACING
+#define MR_MANAGER_ENABLE_TRACING 0
+#endif
+
+#ifndef MR_MANAGER_TRACE_SAMPLE
+#define MR_MANAGER_TRACE_SAMPLE 64
+#endif
+
+#if MR_MANAGER_ENABLE_TRACING
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <typeinfo>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+// arguments: type name, id characters and id length (empty for ids which aren't strings)
+#define MR_MANAGER_PROBE(name, type, id) DTRACE_PROBE3(mr_manager, name, (type).data(), (id).data(), (id).size())
+#else
+#define MR_MANAGER_PROBE(name, type, id) ((void)0)
+#endif
+
+#if defined(TRACY_ENABLE) && __has_include(<tracy/Tracy.hpp>)
+#include <tracy/Tracy.hpp>
+#define MR_MANAGER_ZONE(name, type) ZoneScopedN(name); ZoneText((type).data(), (type).size())
+#else
+#define MR_MANAGER_ZONE(name, type) ((void)0)
+#endif
+#endif
+
+namespace mr {
+enum class TraceOp : std::uint8_t {
+  // named and unnamed creates, try_emplace() included
+  create,
+  find,
+  erase,
+  // destruction of a named entry once the hash map reclaims it
+  reclaim,
+};
+inline constexpr std::size_t trace_op_count = 4;
+
+// sampled call durations in power-of-two buckets, read with Manager<T>::latencies()
+struct LatencyHistogram {
+  static inline constexpr std::size_t bucket_count = 48;
+
+  // buckets[i] counts the calls which took less than 2^i ns (and at least 2^(i-1) ns)
+  std::array<std::uint64_t, bucket_count> buckets {};
+
+  std::uint64_t samples() const noexcept {
+    std::uint64_t total = 0;
+    for (std::uint64_t count : buckets) {
+      total += count;
+    }
+    return total;
+  }
+
+  // upper bound in ns of the bucket holding the q-th quantile, 0 without samples
+  std::uint64_t quantile(double q) const noexcept {
+    std::uint64_t total = samples();
+    if (total == 0) {
+      return 0;
+    }
+    auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucket_count; i++) {
+      seen += buckets[i];
+      if (seen > rank) {
+        return std::uint64_t{1} << i;
+      }
+    }
+    return std::uint64_t{1} << (bucket_count - 1);
+  }
+};
+
+// indexed by TraceOp
+using LatencyHistograms = std::array<LatencyHistogram, trace_op_count>;
+
+namespace detail {
+#if MR_MANAGER_ENABLE_TRACING
+struct TraceHistograms {
+  void record(TraceOp op, std::uint64_t ns) noexcept {
+    std::size_t bucket = std::min<std::size_t>(std::bit_width(ns), LatencyHistogram::bucket_count - 1);
+    buckets[static_cast<std::size_t>(op)][bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  LatencyHistograms read() const noexcept {
+    LatencyHistograms histograms;
+    for (std::size_t op = 0; op < trace_op_count; op++) {
+      for (std::size_t i = 0; i < LatencyHistogram::bucket_count; i++) {
+        histograms[op].buckets[i] = buckets[op][i].load(std::memory_order_relaxed);
+      }
+    }
+    return histograms;
+  }
+
+  std::array<std::array<std::atomic<std::uint64_t>, LatencyHistogram::bucket_count>, trace_op_count> buckets {};
+};
+
+// counted per operation, so that interleaved operations can't keep one from being sampled
+inline bool trace_sampled(TraceOp op) noexcept {
+  thread_local std::array<std::uint32_t, trace_op_count> calls {};
+  return calls[static_cast<std::size_t>(op)]++ % MR_MANAGER_TRACE_SAMPLE == 0;
+}
+
+// demangled where the ABI allows it; null-terminated, as probes take a C string. Immortal,
+// as entries may be reclaimed during static destruction
+template <typename T>
+std::string_view type_name() noexcept {
+  static const std::string *name = new std::string {[] {
+#if __has_include(<cxxabi.h>)
+    int status = 0;
+    if (char *demangled = abi::__cxa_demangle(typeid(T).name(), nullptr, nullptr, &status)) {
+      std::string result {demangled};
+      std::free(demangled);
+      return result;
+    }
+#endif
+    return std::string {typeid(T).name()};
+  }()};
+  return *name;
+}
+
+template <typename Id>
+std::string_view trace_id([[maybe_unused]] const Id &id) noexcept {
+  if constexpr (std::is_convertible_v<const Id &, std::string_view>) {
+    return id;
+  } else if constexpr (requires { { id.str() } -> std::convertible_to<std::string_view>; }) {
+    return id.str();
+  } else {
+    return {};
+  }
+}
+
+// times the enclosing scope if sampled, and calls done() when leaving it
+template <typename Done>
+class TraceScope {
+public:
+  TraceScope(TraceHistograms &histograms, TraceOp op, Done done) noexcept
+  : _histograms(histograms)
+  , _op(op)
+  , _done(done)
+  {
+    if (trace_sampled(op)) {
+      _start = std::chrono::steady_clock::now();
+      _sampled = true;
+    }
+  }
+
+  ~TraceScope() noexcept {
+    if (_sampled) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+      _histograms.record(_op, static_cast<std::uint64_t>(ns));
+    }
+    _done();
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope & operator=(const TraceScope &) = delete;
+
+private:
+  TraceHistograms &_histograms;
+  TraceOp _op;
+  bool _sampled = false;
+  std::chrono::steady_clock::time_point _start;
+  Done _done;
+};
+#else
+struct TraceHistograms {
+  constexpr LatencyHistograms read() const noexcept {
+    return {};
+  }
+};
+#endif
+} // namespace detail
+} // namespace mr
+
+// traces the rest of the enclosing Manager<T> member function as TraceOp::op on 'id';
+// at most one per scope
+#if MR_MANAGER_ENABLE_TRACING
+#define MR_MANAGER_TRACE(op, id)                                                                     \
+  [[maybe_unused]] const std::string_view _mr_trace_type = ::mr::detail::type_name<T>();             \
+  [[maybe_unused]] const std::string_view _mr_trace_id = ::mr::detail::trace_id(id);                 \
+  MR_MANAGER_ZONE("mr::Manager::" #op, _mr_trace_type);                                             \
+  MR_MANAGER_PROBE(op, _mr_trace_type, _mr_trace_id);                                                \
+  ::mr::detail::TraceScope _mr_trace_scope {_histograms(), ::mr::TraceOp::op, [=]() noexcept {       \
+    MR_MANAGER_PROBE(op##_done, _mr_trace_type, _mr_trace_id);                                       \
+  }}
+#else
+#define MR_MANAGER_TRACE(op, id) ((void)0)
+#endif
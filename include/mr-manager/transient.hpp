@@ -0,0 +1,228 @@
+#pragma once
+
+#include <memory_resource>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lockfree.hpp"
+#include "manager.hpp"
+
+namespace mr {
+// Manager<T> variant for objects which live until the next reset(), such as per-frame or
+// per-request temporaries. Each thread bump-allocates from an arena of its own, so create()
+// takes no lock and touches no shared table; ids are the thread's arena plus an index into it.
+// reset() drops every object at once: it only bumps a generation, each thread rewinding its
+// arena on its next create(), plus one pass of destructors if T isn't trivially destructible.
+// reset() must not overlap create() or find(). Arenas grow by doubling segments, starting
+// with AssetPool<T>::initial_capacity objects from AssetPool<T>::upstream(), and are kept
+// for reuse rather than returned on reset().
+template <typename T>
+class TransientManager {
+public:
+  using PoolT = AssetPool<T>;
+
+  struct Id {
+    std::uint32_t arena = detail::invalid_index;
+    std::uint32_t index = 0;
+    std::uint32_t generation = 0;
+
+    constexpr bool operator==(const Id &) const noexcept = default;
+  };
+
+  struct Handle {
+    T* operator->() const noexcept {
+      return ptr;
+    }
+
+    T& value() const noexcept {
+      return *ptr;
+    }
+
+    Id id;
+    T* ptr;
+  };
+
+  static TransientManager & get() noexcept {
+    static TransientManager instance;
+    return instance;
+  }
+
+  template <typename ...Args>
+  Handle create(Args && ...args) noexcept {
+    Arena &arena = _local();
+    std::uint32_t generation = _generation.load(std::memory_order_relaxed);
+    if (arena.generation.load(std::memory_order_relaxed) != generation) [[unlikely]] {
+      arena.generation.store(generation, std::memory_order_relaxed);
+      arena.count.store(0, std::memory_order_relaxed);
+    }
+    std::uint32_t index = static_cast<std::uint32_t>(arena.count.load(std::memory_order_relaxed));
+    T *ptr = detail::construct_at<T>(_allocate(arena, index), std::forward<Args>(args)...);
+    arena.count.store(index + 1, std::memory_order_release);
+    return {{arena.index, index, generation}, ptr};
+  }
+
+  // nullptr once reset() ran since the object was created
+  T * find(Id id) const noexcept {
+    std::uint32_t generation = _generation.load(std::memory_order_relaxed);
+    const std::atomic<Arena *> *entry = _arenas.find(id.arena);
+    Arena *arena = entry == nullptr ? nullptr : entry->load(std::memory_order_acquire);
+    if (arena == nullptr || id.generation != generation || arena->generation.load(std::memory_order_relaxed) != generation
+        || id.index >= arena->count.load(std::memory_order_acquire)) [[unlikely]] {
+      return nullptr;
+    }
+    return _slot(*arena, id.index);
+  }
+
+  // drops every object; O(1) for trivially destructible T, one destructor pass otherwise
+  void reset() noexcept {
+    std::uint32_t generation = _generation.load(std::memory_order_relaxed);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      _destroy_all(generation);
+    }
+    _generation.store(generation + 1, std::memory_order_release);
+  }
+
+  // objects created since the last reset()
+  std::size_t size() const noexcept {
+    std::uint32_t generation = _generation.load(std::memory_order_relaxed);
+    std::size_t total = 0;
+    _for_each_arena([&](const Arena &arena) {
+      if (arena.generation.load(std::memory_order_relaxed) == generation) {
+        total += arena.count.load(std::memory_order_acquire);
+      }
+    });
+    return total;
+  }
+
+private:
+  static inline constexpr std::size_t _first_bits = std::bit_width(std::bit_ceil(std::max<std::size_t>(PoolT::initial_capacity, 1))) - 1;
+  static inline constexpr std::size_t _max_segments = 32 - _first_bits + 1;
+
+  struct Arena {
+    std::uint32_t index = 0;
+    // generation the objects belong to and their number, both set by the owning thread
+    std::atomic<std::uint32_t> generation {0};
+    std::atomic<std::size_t> count {0};
+    std::array<T *, _max_segments> segments {};
+  };
+
+  // a thread's arena goes back to the free list when the thread exits, and is kept
+  // (objects included) until another thread picks it up
+  struct Local {
+    TransientManager *owner = nullptr;
+    Arena *arena = nullptr;
+
+    ~Local() noexcept {
+      if (owner != nullptr) {
+        std::lock_guard lock {owner->_arenas_mutex};
+        owner->_free.push_back(arena);
+      }
+    }
+  };
+
+  TransientManager() noexcept = default;
+
+  ~TransientManager() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      _destroy_all(_generation.load(std::memory_order_relaxed));
+    }
+    std::uint32_t count = _arena_count.load(std::memory_order_acquire);
+    for (std::uint32_t i = 0; i < count; i++) {
+      Arena *arena = _arenas.find(i)->load(std::memory_order_relaxed);
+      for (std::size_t segment = 0; segment < _max_segments; segment++) {
+        if (arena->segments[segment] != nullptr) {
+          PoolT::upstream()->deallocate(arena->segments[segment], _segment_size(segment) * sizeof(T), alignof(T));
+        }
+      }
+      delete arena;
+    }
+  }
+
+  Arena & _local() noexcept {
+    thread_local Local local;
+    if (local.arena == nullptr) [[unlikely]] {
+      local.owner = this;
+      local.arena = _attach();
+    }
+    return *local.arena;
+  }
+
+  Arena * _attach() {
+    std::lock_guard lock {_arenas_mutex};
+    if (!_free.empty()) {
+      Arena *arena = _free.back();
+      _free.pop_back();
+      return arena;
+    }
+    std::uint32_t index = _arena_count.load(std::memory_order_relaxed);
+    auto *arena = new Arena;
+    arena->index = index;
+    arena->generation.store(_generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    _arenas.ensure(index).store(arena, std::memory_order_release);
+    _arena_count.store(index + 1, std::memory_order_release);
+    return arena;
+  }
+
+  template <typename F>
+  void _for_each_arena(F &&f) const {
+    std::uint32_t count = _arena_count.load(std::memory_order_acquire);
+    for (std::uint32_t i = 0; i < count; i++) {
+      f(*_arenas.find(i)->load(std::memory_order_acquire));
+    }
+  }
+
+  void _destroy_all(std::uint32_t generation) noexcept {
+    _for_each_arena([&](Arena &arena) {
+      if (arena.generation.load(std::memory_order_relaxed) != generation) {
+        return;
+      }
+      std::size_t count = arena.count.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i < count; i++) {
+        _slot(arena, static_cast<std::uint32_t>(i))->~T();
+      }
+      arena.count.store(0, std::memory_order_relaxed);
+    });
+  }
+
+  static constexpr std::size_t _segment_of(std::uint32_t index) noexcept {
+    return std::bit_width(index >> _first_bits);
+  }
+  static constexpr std::size_t _segment_begin(std::size_t segment) noexcept {
+    return segment == 0 ? 0 : std::size_t{1} << (_first_bits + segment - 1);
+  }
+  static constexpr std::size_t _segment_size(std::size_t segment) noexcept {
+    return std::size_t{1} << (_first_bits + (segment == 0 ? 0 : segment - 1));
+  }
+
+  static T * _slot(const Arena &arena, std::uint32_t index) noexcept {
+    std::size_t segment = _segment_of(index);
+    return arena.segments[segment] + (index - _segment_begin(segment));
+  }
+
+  // storage for object 'index', allocating its segment on first use
+  static T * _allocate(Arena &arena, std::uint32_t index) noexcept {
+    std::size_t segment = _segment_of(index);
+    if (arena.segments[segment] == nullptr) [[unlikely]] {
+      arena.segments[segment] = static_cast<T *>(PoolT::upstream()->allocate(_segment_size(segment) * sizeof(T), alignof(T)));
+    }
+    return _slot(arena, index);
+  }
+
+  std::atomic<std::uint32_t> _generation {1};
+
+  std::mutex _arenas_mutex;
+  // indexed by Id::arena, so any thread can resolve ids without a lock
+  detail::SegmentedArray<std::atomic<Arena *>, 4> _arenas;
+  std::atomic<std::uint32_t> _arena_count {0};
+  std::vector<Arena *> _free;
+};
+
+} // namespace mr
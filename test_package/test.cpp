@@ -5,19 +5,247 @@
 #include <random>
 #include <barrier>
 #include <latch>
+#include <algorithm>
+#include <cctype>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <fstream>
 
 #include <gtest/gtest.h>
 
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/synchronization/Hazptr.h>
+
+#include <mr-manager/graph.hpp>
 #include <mr-manager/manager.hpp>
+#include <mr-manager/transient.hpp>
 
 using namespace mr;
 
+struct SmallPoolAsset {
+  int value;
+  char payload[60];
+
+  SmallPoolAsset(int v) : value(v) {}
+};
+
+template <> struct mr::AssetPool<SmallPoolAsset> : mr::DefaultAssetPool {
+  static inline constexpr std::size_t initial_capacity = 4;
+};
+
+struct DeferredAsset {
+  static inline std::atomic<int> destroyed = 0;
+
+  int value;
+
+  DeferredAsset(int v) : value(v) {}
+  ~DeferredAsset() { destroyed++; }
+};
+
+template <> struct mr::AssetPolicy<DeferredAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr Reclamation reclamation = Reclamation::deferred;
+};
+
+struct CaseInsensitiveAsset {
+  int value;
+};
+
+template <> struct mr::AssetId<CaseInsensitiveAsset> {
+  struct hash {
+    size_t operator()(const std::string &str) const noexcept {
+      std::string lower;
+      std::ranges::transform(str, std::back_inserter(lower), [](unsigned char c) { return std::tolower(c); });
+      return std::hash<std::string>{}(lower);
+    }
+  };
+  struct key_equal {
+    bool operator()(const std::string &lhs, const std::string &rhs) const noexcept {
+      return std::ranges::equal(lhs, rhs, [](unsigned char a, unsigned char b) {
+        return std::tolower(a) == std::tolower(b);
+      });
+    }
+  };
+
+  using type = std::string;
+};
+
+struct InternedAsset {
+  int value;
+};
+
+template <> struct mr::AssetId<InternedAsset> { using type = mr::InternedId; };
+
+struct BudgetedAsset {
+  int value;
+};
+
+template <> struct mr::AssetPool<BudgetedAsset> : mr::DefaultAssetPool {
+  static inline constexpr std::size_t initial_capacity = 4;
+};
+
+struct NumaAsset {
+  int value;
+};
+
+template <> struct mr::AssetPool<NumaAsset> : mr::DefaultAssetPool {
+  static inline constexpr std::size_t initial_capacity = 16;
+
+  template <typename T> using resource = mr::NumaResource<T, 2>;
+};
+
+struct PaddedAsset {
+  int value;
+};
+
+template <> struct mr::AssetPool<PaddedAsset> : mr::DefaultAssetPool {
+  static inline constexpr std::size_t initial_capacity = 4;
+  static inline constexpr std::size_t block_align = mr::cache_line;
+};
+
+struct alignas(128) OverAlignedAsset {
+  int value;
+};
+
+template <> struct mr::AssetPool<OverAlignedAsset> : mr::DefaultAssetPool {
+  static inline constexpr std::size_t initial_capacity = 4;
+};
+
+template <> struct mr::AssetPolicy<OverAlignedAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr bool iterable = true;
+};
+
+struct ColdAsset {
+  static inline std::atomic<int> decoded = 0;
+
+  int value;
+};
+
+struct ColdAssetCodec {
+  static void encode(const ColdAsset &asset, std::vector<std::byte> &out) {
+    out.resize(sizeof(asset.value));
+    std::memcpy(out.data(), &asset.value, sizeof(asset.value));
+  }
+
+  static ColdAsset decode(std::span<const std::byte> bytes) {
+    ColdAsset::decoded++;
+    ColdAsset asset;
+    std::memcpy(&asset.value, bytes.data(), sizeof(asset.value));
+    return asset;
+  }
+};
+
+template <> struct mr::AssetPolicy<ColdAsset> : mr::DefaultAssetPolicy {
+  using codec = ColdAssetCodec;
+};
+
+struct CompactAsset {
+  int value;
+};
+
+template <> struct mr::AssetPolicy<CompactAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr bool compact_handles = true;
+};
+
+struct GraphTexture {
+  int value;
+};
+
+struct GraphMaterial {
+  int value;
+};
+
+struct SnapshotAsset {
+  static inline std::atomic<int> destroyed = 0;
+
+  int value;
+
+  SnapshotAsset(int v) : value(v) {}
+  ~SnapshotAsset() { destroyed++; }
+};
+
+template <> struct mr::AssetPolicy<SnapshotAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr bool snapshot = true;
+};
+
+struct SharedAsset {
+  static inline std::atomic<int> destroyed = 0;
+
+  int value;
+
+  SharedAsset(int v) : value(v) {}
+  ~SharedAsset() { destroyed++; }
+};
+
+template <> struct mr::AssetPolicy<SharedAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr bool shared = true;
+};
+
+struct CachedAsset {
+  int value;
+};
+
+template <> struct mr::AssetPolicy<CachedAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr std::size_t budget = 4;
+};
+
+struct TransformAsset {
+  int x;
+};
+
+template <> struct mr::AssetPolicy<TransformAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr bool iterable = true;
+};
+
+struct ReloadableAsset {
+  int value;
+};
+
+template <> struct mr::AssetPolicy<ReloadableAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr bool versioned = true;
+};
+
+struct CachedLookupAsset {
+  int value;
+};
+
+template <> struct mr::AssetPolicy<CachedLookupAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr std::size_t lookup_cache = 16;
+};
+
+struct FrameAsset {
+  static inline std::atomic<int> destroyed = 0;
+
+  int value;
+
+  FrameAsset(int v) : value(v) {}
+  ~FrameAsset() { destroyed++; }
+};
+
+struct StoredAsset {
+  int value;
+  double weight;
+};
+
+template <> struct mr::AssetPolicy<StoredAsset> : mr::DefaultAssetPolicy {
+  static inline constexpr bool iterable = true;
+};
+
+struct StaticAsset {
+  int value;
+};
+
+template <> struct mr::AssetPolicy<StaticAsset> : mr::DefaultAssetPolicy {
+  using static_assets = mr::StaticAssets<"static/basic", "static/pbr", "static/sky">;
+};
+
 class ManagerTest : public ::testing::Test {
 protected:
   void TearDown() override {
     // Clear all managers after each test
-    Manager<int>::get().clear();
-    Manager<std::string>::get().clear();
+    Registry::get().clear();
   }
 };
 
@@ -104,6 +332,1296 @@ TEST_F(ManagerTest, MemoryReclamation) {
   EXPECT_EQ(new_handle.value(), 99);
 }
 
+TEST_F(ManagerTest, TryEmplaceKeepsExisting) {
+  auto& manager = Manager<int>::get();
+  const std::string id = "try_emplace_test";
+
+  auto handle1 = manager.try_emplace(id, 1);
+  auto handle2 = manager.try_emplace(id, 2);
+
+  EXPECT_EQ(handle1.value(), 1);
+  EXPECT_EQ(handle2.value(), 1);
+  EXPECT_EQ(&handle1.value(), &handle2.value());
+  EXPECT_EQ(manager.size(), 1);
+}
+
+TEST_F(ManagerTest, InsertOrAssignReplaces) {
+  auto& manager = Manager<int>::get();
+  const std::string id = "insert_or_assign_test";
+
+  manager.insert_or_assign(id, 1);
+  auto handle = manager.insert_or_assign(id, 2);
+
+  EXPECT_EQ(handle.value(), 2);
+  EXPECT_EQ(manager.find(id)->value(), 2);
+  EXPECT_EQ(manager.size(), 1);
+}
+
+TEST_F(ManagerTest, BraceInitialization) {
+  auto& manager = Manager<std::vector<int>>::get();
+  EXPECT_EQ(manager.create("braced", 3, 7).value(), (std::vector<int> {3, 7}));
+  // arguments braces can't take (here a narrowing size) fall back to parentheses
+  std::size_t size = 2;
+  EXPECT_EQ(manager.create("sized", size, 7).value(), (std::vector<int> {7, 7}));
+  manager.clear();
+}
+
+TEST_F(ManagerTest, InPlaceConstruction) {
+  struct Immovable {
+    int value;
+
+    Immovable(int v) : value(v) {}
+    Immovable(const Immovable &) = delete;
+    Immovable(Immovable &&) = delete;
+  };
+
+  auto& manager = Manager<Immovable>::get();
+  auto handle = manager.create("immovable", 7);
+  EXPECT_EQ(handle->value, 7);
+
+  handle = manager.try_emplace("immovable", 8);
+  EXPECT_EQ(handle->value, 7);
+
+  manager.clear();
+}
+
+TEST_F(ManagerTest, UnnamedObjectCreation) {
+  auto& manager = Manager<int>::get();
+
+  auto handle1 = manager.create(unnamed, 1);
+  auto handle2 = manager.create(unnamed, 2);
+  EXPECT_NE(handle1.id, handle2.id);
+  EXPECT_EQ(manager.size(), 2);
+
+  auto found = manager.find(handle2.id);
+  ASSERT_TRUE(found);
+  EXPECT_EQ(found->value(), 2);
+  EXPECT_EQ(found->ptr, handle2.ptr);
+}
+
+TEST_F(ManagerTest, UnnamedIdInvalidatedByClear) {
+  auto& manager = Manager<int>::get();
+
+  auto stale = manager.create(unnamed, 1).id;
+  manager.clear();
+  EXPECT_FALSE(manager.find(stale));
+
+  // the slot is recycled under a new generation
+  auto fresh = manager.create(unnamed, 2).id;
+  EXPECT_EQ(fresh.index, stale.index);
+  EXPECT_NE(fresh.generation, stale.generation);
+  EXPECT_FALSE(manager.find(stale));
+  EXPECT_EQ(manager.find(fresh)->value(), 2);
+}
+
+TEST_F(ManagerTest, ConcurrentUnnamedCreation) {
+  auto& manager = Manager<int>::get();
+  constexpr int num_threads = 4;
+  constexpr int operations_per_thread = 10000;
+
+  std::vector<std::vector<UnnamedId>> ids(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < operations_per_thread; ++i) {
+        ids[t].push_back(manager.create(unnamed, t * operations_per_thread + i).id);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(manager.size(), num_threads * operations_per_thread);
+  for (int t = 0; t < num_threads; ++t) {
+    for (int i = 0; i < operations_per_thread; ++i) {
+      EXPECT_EQ(manager.find(ids[t][i])->value(), t * operations_per_thread + i);
+    }
+  }
+}
+
+TEST_F(ManagerTest, PoolGrowsWithoutMovingObjects) {
+  auto& manager = Manager<SmallPoolAsset>::get();
+  constexpr int count = 100;
+
+  std::vector<SmallPoolAsset *> addresses;
+  for (int i = 0; i < count; ++i) {
+    addresses.push_back(manager.create(unnamed, i).ptr);
+  }
+
+  EXPECT_GT(Manager<SmallPoolAsset>::_memory_resource.arena_count(), 1);
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(addresses[i]->value, i);
+  }
+
+  manager.clear();
+}
+
+TEST(SlabResourceTest, ArenasFollowGrowthPolicy) {
+  SlabResource slab {16, 16, 4, [](std::size_t capacity) noexcept { return capacity * 2; },
+                     std::pmr::new_delete_resource()};
+  EXPECT_EQ(slab.arena_count(), 0);
+
+  std::vector<void *> blocks;
+  for (int i = 0; i < 4; ++i) {
+    blocks.push_back(slab.allocate(16, 16));
+  }
+  EXPECT_EQ(slab.arena_count(), 1);
+  EXPECT_EQ(slab.capacity(), 4 * 16);
+
+  blocks.push_back(slab.allocate(16, 16));
+  EXPECT_EQ(slab.arena_count(), 2);
+  EXPECT_EQ(slab.capacity(), (4 + 8) * 16);
+
+  std::sort(blocks.begin(), blocks.end());
+  EXPECT_EQ(std::adjacent_find(blocks.begin(), blocks.end()), blocks.end());
+
+  slab.release();
+  EXPECT_EQ(slab.capacity(), 0);
+}
+
+TEST(MagazineResourceTest, ReusesFreedBlocks) {
+  struct Tag {};
+  SlabResource slab {32, 8, 1024, DefaultAssetPool::grow, std::pmr::new_delete_resource()};
+  MagazineResource<Tag> pool {&slab};
+
+  void *block = pool.allocate(32, 8);
+  pool.deallocate(block, 32, 8);
+  EXPECT_EQ(pool.allocate(32, 8), block);
+
+  // objects which don't fit a block bypass the magazines
+  void *large = pool.allocate(64, 8);
+  EXPECT_NE(large, block);
+  pool.deallocate(large, 64, 8);
+}
+
+TEST(MagazineResourceTest, BlocksMigrateBetweenThreads) {
+  struct Tag {};
+  constexpr std::size_t count = MagazineResource<Tag>::magazine_size * 4;
+  SlabResource slab {32, 8, 1024, DefaultAssetPool::grow, std::pmr::new_delete_resource()};
+  MagazineResource<Tag> pool {&slab};
+
+  std::vector<void *> blocks;
+  for (std::size_t i = 0; i < count; ++i) {
+    blocks.push_back(pool.allocate(32, 8));
+  }
+  std::size_t capacity = slab.capacity();
+
+  // blocks freed on another thread reach the depot when it exits
+  std::thread([&] {
+    for (void *block : blocks) {
+      pool.deallocate(block, 32, 8);
+    }
+  }).join();
+
+  std::sort(blocks.begin(), blocks.end());
+  for (std::size_t i = 0; i < count; ++i) {
+    void *block = pool.allocate(32, 8);
+    EXPECT_TRUE(std::binary_search(blocks.begin(), blocks.end(), block));
+  }
+  EXPECT_EQ(slab.capacity(), capacity);
+}
+
+TEST_F(ManagerTest, DeferredReclamation) {
+  auto& manager = Manager<DeferredAsset>::get();
+  manager.collect();
+  DeferredAsset::destroyed = 0;
+
+  DeferredAsset *old_value = manager.create(unnamed, 1).ptr;
+  manager.clear();
+
+  // retired objects stay intact until collect()
+  EXPECT_EQ(DeferredAsset::destroyed, 0);
+  EXPECT_EQ(manager.retired(), 1);
+  EXPECT_EQ(old_value->value, 1);
+
+  EXPECT_EQ(manager.collect(), 1);
+  EXPECT_EQ(DeferredAsset::destroyed, 1);
+  EXPECT_EQ(manager.retired(), 0);
+}
+
+TEST_F(ManagerTest, DeferredReclamationAcrossThreads) {
+  auto& manager = Manager<DeferredAsset>::get();
+  manager.collect();
+  DeferredAsset::destroyed = 0;
+  constexpr int num_threads = 4;
+  constexpr int operations_per_thread = 100;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < operations_per_thread; ++i) {
+        auto handle = manager.create(unnamed, i);
+        manager.collect();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  manager.clear();
+  manager.collect();
+  EXPECT_EQ(DeferredAsset::destroyed, num_threads * operations_per_thread);
+  EXPECT_EQ(manager.retired(), 0);
+}
+
+TEST_F(ManagerTest, EraseSingleAsset) {
+  auto& manager = Manager<int>::get();
+  manager.create("keep", 1);
+  manager.create("drop", 2);
+  auto id = manager.create(unnamed, 3).id;
+
+  EXPECT_EQ(manager.erase("drop"), 1);
+  EXPECT_EQ(manager.erase("drop"), 0);
+  EXPECT_EQ(manager.erase(id), 1);
+  EXPECT_EQ(manager.erase(id), 0);
+
+  EXPECT_FALSE(manager.find("drop"));
+  EXPECT_FALSE(manager.find(id));
+  EXPECT_EQ(manager.find("keep")->value(), 1);
+  EXPECT_EQ(manager.size(), 1);
+}
+
+TEST_F(ManagerTest, EraseReusesPoolBlock) {
+  auto& manager = Manager<int>::get();
+
+  auto handle = manager.create(unnamed, 1);
+  int *block = handle.ptr;
+  manager.erase(handle.id);
+
+  EXPECT_EQ(manager.create(unnamed, 2).ptr, block);
+}
+
+TEST_F(ManagerTest, BulkErase) {
+  auto& manager = Manager<int>::get();
+  std::vector<std::string> names;
+  std::vector<UnnamedId> ids;
+  for (int i = 0; i < 10; ++i) {
+    names.push_back("bulk_" + std::to_string(i));
+    manager.create(names.back(), i);
+    ids.push_back(manager.create(unnamed, i).id);
+  }
+
+  EXPECT_EQ(manager.erase(std::span<const std::string>(names).first(5)), 5);
+  EXPECT_EQ(manager.erase(std::span<const UnnamedId>(ids)), 10);
+  EXPECT_EQ(manager.size(), 5);
+}
+
+TEST_F(ManagerTest, EraseIf) {
+  auto& manager = Manager<int>::get();
+  for (int i = 0; i < 10; ++i) {
+    manager.create("erase_if_" + std::to_string(i), i);
+    manager.create(unnamed, i);
+  }
+
+  // named entries only
+  EXPECT_EQ(manager.erase_if([](const std::string &, int value) { return value < 5; }), 5);
+  EXPECT_EQ(manager.size(), 15);
+
+  // both tables
+  EXPECT_EQ(manager.erase_if([](const auto &, int value) { return value % 2 == 1; }), 8);
+  EXPECT_EQ(manager.size(), 7);
+}
+
+TEST_F(ManagerTest, Extract) {
+  auto& manager = Manager<std::string>::get();
+  manager.create("extract", "value");
+  auto id = manager.create(unnamed, "unnamed value").id;
+
+  EXPECT_EQ(manager.extract("extract"), "value");
+  EXPECT_EQ(manager.extract("extract"), std::nullopt);
+  EXPECT_EQ(manager.extract(id), "unnamed value");
+  EXPECT_EQ(manager.extract(id), std::nullopt);
+  EXPECT_EQ(manager.size(), 0);
+}
+
+TEST_F(ManagerTest, ReserveAndFindBulk) {
+  auto& manager = Manager<std::string>::get();
+  constexpr int count = 1000;
+
+  manager.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    manager.create("bulk_" + std::to_string(i), i % 10 + 1, 'x');
+  }
+  EXPECT_EQ(manager.size(), count);
+
+  std::vector<std::string> ids {"bulk_0", "missing", "bulk_999"};
+  std::vector<std::optional<Manager<std::string>::Handle>> found(ids.size());
+  EXPECT_EQ(manager.find_bulk(ids, found), 2);
+  EXPECT_EQ(found[0]->value(), "x");
+  EXPECT_FALSE(found[1]);
+  EXPECT_EQ(found[2]->value(), std::string(10, 'x'));
+}
+
+TEST_F(ManagerTest, FindBulkUnnamed) {
+  auto& manager = Manager<int>::get();
+
+  std::vector<UnnamedId> ids {manager.create(unnamed, 4).id, UnnamedId{}};
+  std::vector<std::optional<Manager<int>::UnnamedHandle>> found(ids.size());
+  EXPECT_EQ(manager.find_bulk(ids, found), 1);
+  EXPECT_EQ(found[0]->value(), 4);
+}
+
+TEST_F(ManagerTest, HeterogeneousLookup) {
+  auto& manager = Manager<int>::get();
+  manager.create("heterogeneous", 5);
+
+  std::string buffer = "GET heterogeneous HTTP/1.1";
+  std::string_view id = std::string_view(buffer).substr(4, 13);
+  ASSERT_TRUE(manager.find(id));
+  EXPECT_EQ(manager.find(id)->value(), 5);
+  EXPECT_EQ(manager.find("heterogeneous")->value(), 5);
+  EXPECT_FALSE(manager.find(std::string_view("missing")));
+
+  EXPECT_EQ(StringHash{}(id), std::hash<std::string>{}("heterogeneous"));
+}
+
+TEST_F(ManagerTest, CustomIdHasher) {
+  auto& manager = Manager<CaseInsensitiveAsset>::get();
+  manager.create("Case", 1);
+
+  EXPECT_EQ(manager.find("CASE")->value().value, 1);
+  // the hasher isn't transparent, so views go through an id buffer
+  EXPECT_EQ(manager.find(std::string_view("cASE"))->value().value, 1);
+  manager.create("case", 2);
+  EXPECT_EQ(manager.size(), 1);
+
+  manager.clear();
+}
+
+TEST_F(ManagerTest, InternedIds) {
+  using namespace mr::literals;
+
+  static_assert("ui/atlas"_id.hash == hash_id("ui/atlas"));
+  static_assert(std::string_view("ui/atlas"_id) == "ui/atlas");
+
+  InternedId a {"ui/atlas"};
+  InternedId b {std::string("ui/") + "atlas"};
+  InternedId c = "ui/atlas"_id;
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a, c);
+  EXPECT_NE(a, InternedId {"ui/other"});
+  EXPECT_EQ(std::hash<InternedId>{}(a), "ui/atlas"_id.hash);
+  EXPECT_EQ(a.str(), "ui/atlas");
+  EXPECT_EQ(InternedId{}, InternedId{""});
+}
+
+TEST_F(ManagerTest, InternedAssetIds) {
+  using namespace mr::literals;
+  auto& manager = Manager<InternedAsset>::get();
+
+  manager.create("ui/atlas"_id, 1);
+  manager.create(InternedId {"ui/font"}, 2);
+
+  EXPECT_EQ(manager.find("ui/atlas"_id)->value().value, 1);
+  EXPECT_EQ(manager.find(std::string_view("ui/font"))->value().value, 2);
+  EXPECT_EQ(manager.find(InternedId {"ui/atlas"})->value().value, 1);
+  EXPECT_FALSE(manager.find("ui/missing"_id));
+
+  // probing with a string never interned misses without interning it
+  std::size_t interned = detail::InternPool::get().size();
+  EXPECT_FALSE(manager.find(std::string_view("ui/never_created")));
+  EXPECT_FALSE(manager.find("ui/never_created_either"));
+  EXPECT_EQ(detail::InternPool::get().size(), interned);
+
+  // literal ids also probe ordinary string tables
+  Manager<int>::get().create("ui/atlas", 3);
+  EXPECT_EQ(Manager<int>::get().find("ui/atlas"_id)->value(), 3);
+
+  manager.clear();
+}
+
+TEST_F(ManagerTest, CompactHandle) {
+  auto& manager = Manager<CompactAsset>::get();
+  static_assert(sizeof(Manager<CompactAsset>::CompactHandle) == 8);
+
+  auto named = manager.create("compact", 1).compact();
+  auto unnamed_handle = manager.create(unnamed, 2).compact();
+  EXPECT_EQ(named.value().value, 1);
+  EXPECT_EQ(unnamed_handle.get()->value, 2);
+
+  // handles are plain values and can be stored in bulk
+  std::vector<Manager<CompactAsset>::CompactHandle> handles(1000, named);
+  handles[500].value().value = 3;
+  EXPECT_EQ(manager.find("compact")->value().value, 3);
+
+  manager.erase("compact");
+  folly::hazptr_cleanup();
+  EXPECT_FALSE(named);
+  EXPECT_EQ(named.get(), nullptr);
+
+  manager.erase(unnamed_handle.slot);
+  EXPECT_FALSE(unnamed_handle);
+}
+
+TEST_F(ManagerTest, CompactHandleSurvivesUntilReclamation) {
+  auto& manager = Manager<CompactAsset>::get();
+
+  auto handle = manager.create("compact_overwrite", 1);
+  auto compact = handle.compact();
+  manager.create("compact_overwrite", 2);
+
+  // the pinned entry is still alive, and so is its compact handle
+  EXPECT_EQ(compact.value().value, 1);
+  EXPECT_EQ(manager.find("compact_overwrite")->compact().value().value, 2);
+  EXPECT_NE(compact, manager.find("compact_overwrite")->compact());
+}
+
+TEST_F(ManagerTest, SharedHandleEvictsOnLastRelease) {
+  auto& manager = Manager<SharedAsset>::get();
+
+  auto shared = manager.create("shared", 1).share();
+  auto copy = shared;
+  shared.set_evictable();
+
+  shared = {};
+  EXPECT_TRUE(manager.find("shared"));
+
+  copy = {};
+  folly::hazptr_cleanup();
+  EXPECT_FALSE(manager.find("shared"));
+  EXPECT_EQ(manager.size(), 0);
+
+  // without set_evictable() the entry stays in the table
+  manager.create("kept", 2).share();
+  EXPECT_EQ(manager.find("kept")->value().value, 2);
+  manager.clear();
+}
+
+TEST_F(ManagerTest, SharedHandleOutlivesEntry) {
+  auto& manager = Manager<SharedAsset>::get();
+  folly::hazptr_cleanup();
+  SharedAsset::destroyed = 0;
+
+  auto shared = manager.create("outlived", 1).share();
+  manager.create("outlived", 2);
+  folly::hazptr_cleanup();
+
+  // the replaced entry is gone but its object is still referenced
+  EXPECT_EQ(SharedAsset::destroyed, 0);
+  EXPECT_EQ(shared->value, 1);
+
+  shared = {};
+  EXPECT_EQ(SharedAsset::destroyed, 1);
+  EXPECT_EQ(manager.find("outlived")->value().value, 2);
+
+  auto unnamed_handle = manager.create(unnamed, 3);
+  shared = unnamed_handle.share();
+  shared.set_evictable();
+  shared = {};
+  EXPECT_FALSE(manager.find(unnamed_handle.id));
+  EXPECT_EQ(SharedAsset::destroyed, 2);
+  manager.clear();
+}
+
+TEST_F(ManagerTest, BudgetEvictsUnreferencedEntries) {
+  auto& manager = Manager<CachedAsset>::get();
+
+  for (int i = 0; i < 5; i++) {
+    manager.create("cached_" + std::to_string(i), i);
+  }
+  EXPECT_EQ(manager.size(), 4);
+  EXPECT_EQ(manager.cost(), 4);
+  EXPECT_TRUE(manager.find("cached_4"));
+
+  // a hit gives an entry a second chance over the ones nobody looked up
+  std::string hot;
+  for (int i = 0; i < 4; i++) {
+    if (manager.find("cached_" + std::to_string(i))) {
+      hot = "cached_" + std::to_string(i);
+      break;
+    }
+  }
+  manager.create("cached_5", 5);
+  EXPECT_EQ(manager.size(), 4);
+  EXPECT_TRUE(manager.find(hot));
+  EXPECT_TRUE(manager.find("cached_5"));
+
+  manager.clear();
+  folly::hazptr_cleanup();
+  EXPECT_EQ(manager.cost(), 0);
+}
+
+TEST_F(ManagerTest, CreateAsyncDeduplicatesLoads) {
+  auto& manager = Manager<std::string>::get();
+  folly::CPUThreadPoolExecutor executor {2};
+  std::atomic<int> loads = 0;
+  std::latch release {1};
+
+  auto loader = [&] {
+    loads++;
+    release.wait();
+    return std::string("decoded");
+  };
+  auto first = manager.create_async("async", loader, folly::getKeepAliveToken(executor));
+  auto second = manager.create_async("async", loader, folly::getKeepAliveToken(executor));
+  release.count_down();
+
+  EXPECT_EQ(std::move(first).get().value(), "decoded");
+  EXPECT_EQ(std::move(second).get().value(), "decoded");
+  EXPECT_EQ(loads, 1);
+}
+
+TEST_F(ManagerTest, CreateAsyncPropagatesLoaderErrors) {
+  auto& manager = Manager<std::string>::get();
+  folly::CPUThreadPoolExecutor executor {1};
+
+  auto failed = manager.create_async("async_error", []() -> std::string {
+    throw std::runtime_error("corrupt file");
+  }, folly::getKeepAliveToken(executor));
+  EXPECT_THROW(std::move(failed).get(), std::runtime_error);
+  EXPECT_FALSE(manager.find("async_error"));
+
+  // the failed load is forgotten, so the next call loads again
+  auto retried = manager.create_async("async_error", [] { return std::string("recovered"); }, folly::getKeepAliveToken(executor));
+  EXPECT_EQ(std::move(retried).get().value(), "recovered");
+}
+
+TEST_F(ManagerTest, FindOrLoadSharesOneLoad) {
+  auto& manager = Manager<std::string>::get();
+  std::atomic<int> loads = 0;
+  std::latch started {1};
+  std::latch release {1};
+
+  std::thread leader([&] {
+    auto handle = folly::coro::blockingWait(manager.find_or_load("coro", [&] {
+      loads++;
+      started.count_down();
+      release.wait();
+      return std::string("loaded");
+    }));
+    EXPECT_EQ(handle.value(), "loaded");
+  });
+  started.wait();
+
+  std::thread waiter([&] {
+    auto handle = folly::coro::blockingWait(manager.find_or_load("coro", [&] {
+      loads++;
+      return std::string("duplicate");
+    }));
+    EXPECT_EQ(handle.value(), "loaded");
+  });
+  release.count_down();
+  leader.join();
+  waiter.join();
+  EXPECT_EQ(loads, 1);
+
+  // hits don't call the loader
+  auto hit = folly::coro::blockingWait(manager.find_or_load("coro", [&] {
+    loads++;
+    return std::string("reloaded");
+  }));
+  EXPECT_EQ(hit.value(), "loaded");
+  EXPECT_EQ(loads, 1);
+}
+
+TEST_F(ManagerTest, FindOrLoadAwaitsTaskLoaders) {
+  auto& manager = Manager<std::string>::get();
+
+  auto handle = folly::coro::blockingWait(manager.find_or_load("coro_task", []() -> folly::coro::Task<std::string> {
+    co_return std::string("awaited");
+  }));
+  EXPECT_EQ(handle.value(), "awaited");
+
+  EXPECT_THROW(folly::coro::blockingWait(manager.find_or_load("coro_error", []() -> std::string {
+    throw std::runtime_error("missing file");
+  })), std::runtime_error);
+  EXPECT_FALSE(manager.find("coro_error"));
+}
+
+TEST_F(ManagerTest, Stats) {
+  auto& manager = Manager<CachedAsset>::get();
+  ManagerStats before = manager.stats();
+
+  manager.create("stats", 1);
+  manager.create("stats", 2);
+  manager.find("stats");
+  manager.find("stats_missing");
+  manager.erase("stats");
+
+  ManagerStats stats = manager.stats();
+  EXPECT_EQ(stats.entries, 0);
+  EXPECT_GE(stats.pool_arenas, 1);
+  EXPECT_GE(stats.pool_capacity, sizeof(CachedAsset));
+  // creates and destroyed back memory(), so they are counted either way
+  EXPECT_EQ(stats.creates - before.creates, 2);
+  if constexpr (MR_MANAGER_ENABLE_STATS) {
+    EXPECT_EQ(stats.overwrites - before.overwrites, 1);
+    EXPECT_EQ(stats.hits - before.hits, 1);
+    EXPECT_EQ(stats.misses - before.misses, 1);
+    EXPECT_EQ(stats.erases - before.erases, 1);
+  } else {
+    EXPECT_EQ(stats.hits, 0);
+  }
+  folly::hazptr_cleanup();
+  EXPECT_EQ(manager.stats().unreclaimed, 0);
+}
+
+TEST_F(ManagerTest, RegistryListsAndClearsManagers) {
+  Manager<int>::get().create("registry_int", 1);
+  Manager<std::string>::get().create("registry_string", "value");
+
+  bool found = false;
+  Registry::get().for_each([&](const ManagerInfo &info) {
+    found |= *info.type == typeid(int);
+  });
+  EXPECT_TRUE(found);
+  EXPECT_GE(Registry::get().memory(), 2 * sizeof(int));
+
+  Registry::get().clear();
+  EXPECT_EQ(Manager<int>::get().size(), 0);
+  EXPECT_EQ(Manager<std::string>::get().size(), 0);
+}
+
+TEST_F(ManagerTest, RegistryTrimsLargestTypes) {
+  auto& manager = Manager<int>::get();
+  for (int i = 0; i < 100; i++) {
+    manager.create("trim_" + std::to_string(i), i);
+  }
+  manager.create("trim_other", 1);
+  Manager<std::string>::get().create("trim_string", "kept");
+  folly::hazptr_cleanup();
+
+  size_t before = Registry::get().memory();
+  size_t released = Registry::get().trim(before - 50 * sizeof(int));
+  EXPECT_GE(released, 50 * sizeof(int));
+  EXPECT_LE(manager.size(), 51);
+  EXPECT_TRUE(Manager<std::string>::get().find("trim_string"));
+}
+
+TEST_F(ManagerTest, RegistryBudgetIsEnforcedOnPoolGrowth) {
+  auto& manager = Manager<BudgetedAsset>::get();
+  folly::hazptr_cleanup();
+  Registry::get().set_budget(Registry::get().memory() + 8 * Manager<BudgetedAsset>::_memory_resource.block_size());
+
+  for (int i = 0; i < 64; i++) {
+    manager.create("budgeted_" + std::to_string(i), i);
+  }
+  Registry::get().set_budget(0);
+  EXPECT_LT(manager.size(), 64);
+  EXPECT_TRUE(manager.find("budgeted_63"));
+}
+
+TEST_F(ManagerTest, NumaPools) {
+  auto& manager = Manager<NumaAsset>::get();
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 100; i++) {
+        std::string id = "numa_" + std::to_string(t) + "_" + std::to_string(i);
+        manager.create(id, i);
+        EXPECT_EQ(manager.find(id)->value().value, i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(manager.size(), 400);
+
+  auto &pool = Manager<NumaAsset>::_memory_pool_resource;
+  EXPECT_GE(manager.stats().pool_capacity, 400 * sizeof(NumaAsset));
+  EXPECT_EQ(Manager<NumaAsset>::_memory_resource.arena_count(), 0);
+
+  // every object lives in one of the node pools
+  for (int i = 0; i < 100; i++) {
+    NumaAsset *ptr = manager.find("numa_0_" + std::to_string(i))->operator->();
+    EXPECT_TRUE(pool.node(0).owns(ptr) || pool.node(1).owns(ptr));
+  }
+}
+
+TEST_F(ManagerTest, SnapshotReads) {
+  auto& manager = Manager<SnapshotAsset>::get();
+  manager.create("snapshot", 1);
+
+  // single writes are batched until publish()
+  EXPECT_FALSE(manager.find_snapshot("snapshot"));
+  manager.publish();
+  EXPECT_EQ(manager.find_snapshot(std::string_view("snapshot"))->value().value, 1);
+  EXPECT_FALSE(manager.find_snapshot("snapshot_missing"));
+}
+
+TEST_F(ManagerTest, FindSnapshotBatch) {
+  auto& manager = Manager<SnapshotAsset>::get();
+  std::vector<std::string_view> ids {"batch_a", "batch_missing", "batch_b"};
+  manager.create("batch_a", 1);
+  manager.create("batch_b", 2);
+  manager.publish();
+  std::vector<const SnapshotAsset *> out(ids.size());
+
+  folly::rcu_reader guard;
+  EXPECT_EQ(manager.find_snapshot_batch(std::span<const std::string_view> {ids}, std::span {out}, guard), 2);
+  EXPECT_EQ(out[0]->value, 1);
+  EXPECT_EQ(out[1], nullptr);
+  EXPECT_EQ(out[2]->value, 2);
+}
+
+TEST_F(ManagerTest, SnapshotKeepsObjectsUntilRepublished) {
+  auto& manager = Manager<SnapshotAsset>::get();
+  manager.create("snapshot_old", 1);
+  manager.publish();
+  folly::hazptr_cleanup();
+  SnapshotAsset::destroyed = 0;
+
+  manager.create("snapshot_old", 2);
+  manager.erase("snapshot_old");
+  folly::hazptr_cleanup();
+
+  // the snapshot still references the replaced object
+  EXPECT_EQ(SnapshotAsset::destroyed, 1);
+  EXPECT_EQ(manager.find_snapshot("snapshot_old")->value().value, 1);
+
+  manager.publish();
+  folly::synchronize_rcu();
+  EXPECT_EQ(SnapshotAsset::destroyed, 2);
+  EXPECT_FALSE(manager.find_snapshot("snapshot_old"));
+}
+
+TEST(StaticAssetsTest, ResolvesPositions) {
+  using Ids = mr::StaticAssets<"a", "b", "c">;
+  static_assert(Ids::index_of<"b"> == 1);
+  static_assert(Ids::index_of<"d"> == Ids::size);
+  static_assert(Ids::find(mr::HashedId {"c"}) == 2);
+
+  EXPECT_EQ(Ids::find(mr::HashedId {std::string("a")}), 0);
+  EXPECT_EQ(Ids::find(mr::HashedId {"missing"}), Ids::size);
+  EXPECT_EQ(mr::StaticAssets<>::find(mr::HashedId {"a"}), mr::StaticAssets<>::size);
+}
+
+TEST_F(ManagerTest, StaticAssets) {
+  using namespace mr::literals;
+  auto& manager = Manager<StaticAsset>::get();
+  EXPECT_EQ(manager.find_static("static/basic"_id), nullptr);
+
+  manager.create("static/basic", 1);
+  manager.create("dynamic", 2);
+  EXPECT_EQ(manager.find_static("static/basic"_id)->value, 1);
+  EXPECT_EQ(manager.find("static/basic")->value().value, 1);
+
+  manager.create("static/basic", 3);
+  EXPECT_EQ(manager.find_static("static/basic"_id)->value, 3);
+
+  manager.try_emplace("static/pbr", 4);
+  manager.try_emplace("static/pbr", 5);
+  EXPECT_EQ(manager.find_static("static/pbr"_id)->value, 4);
+
+  manager.erase("static/basic");
+  EXPECT_EQ(manager.find_static("static/basic"_id), nullptr);
+
+  manager.erase_if([](const std::string &, const StaticAsset &asset) { return asset.value == 4; });
+  EXPECT_EQ(manager.find_static("static/pbr"_id), nullptr);
+  EXPECT_EQ(manager.find("dynamic")->value().value, 2);
+}
+
+TEST(SlabResourceTest, TracksLiveBlocks) {
+  SlabResource slab {16, 16, 100, DefaultAssetPool::grow, std::pmr::new_delete_resource()};
+  std::vector<void *> expected;
+  for (int i = 0; i < 150; i++) {
+    void *block = slab.allocate(16, 16);
+    slab.set_live(block, true);
+    if (i % 3 == 0) {
+      slab.set_live(block, false);
+    } else {
+      expected.push_back(block);
+    }
+  }
+
+  std::vector<void *> live;
+  for (const BlockRange &range : slab.live_ranges(64)) {
+    range.for_each([&](void *block) { live.push_back(block); });
+  }
+  std::ranges::sort(live);
+  std::ranges::sort(expected);
+  EXPECT_EQ(live, expected);
+  EXPECT_GT(slab.live_ranges(64).size(), slab.arena_count());
+}
+
+TEST(SlabResourceTest, FindsArenasByAddress) {
+  SlabResource slab {16, 16, 1, DefaultAssetPool::grow, std::pmr::new_delete_resource()};
+  std::vector<void *> blocks;
+  for (int i = 0; i < 1000; i++) {
+    blocks.push_back(slab.allocate(16, 16));
+  }
+  alignas(16) std::byte adopted[64];
+  slab.adopt(adopted, 4);
+  EXPECT_GE(slab.arena_count(), 8u);
+
+  for (void *block : blocks) {
+    EXPECT_TRUE(slab.owns(block));
+  }
+  EXPECT_TRUE(slab.owns(adopted + 48));
+  EXPECT_FALSE(slab.owns(adopted + 64));
+  int outside = 0;
+  EXPECT_FALSE(slab.owns(&outside));
+
+  std::size_t visited = 0;
+  slab.set_live(adopted + 16, false);
+  for (const BlockRange &range : slab.live_ranges()) {
+    range.for_each([&](void *) { visited++; });
+  }
+  EXPECT_EQ(visited, 3u);
+}
+
+TEST_F(ManagerTest, BlockAlignment) {
+  auto& padded = Manager<PaddedAsset>::get();
+  auto& aligned = Manager<OverAlignedAsset>::get();
+  std::vector<std::uintptr_t> padded_addresses;
+  for (int i = 0; i < 10; i++) {
+    auto handle = padded.create("padded_" + std::to_string(i), i);
+    padded_addresses.push_back(reinterpret_cast<std::uintptr_t>(handle.operator->()));
+    auto over = aligned.create("aligned_" + std::to_string(i), i);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(over.operator->()) % 128, 0);
+  }
+  std::ranges::sort(padded_addresses);
+  for (size_t i = 0; i < padded_addresses.size(); i++) {
+    EXPECT_EQ(padded_addresses[i] % mr::cache_line, 0);
+    if (i > 0) {
+      EXPECT_GE(padded_addresses[i] - padded_addresses[i - 1], mr::cache_line);
+    }
+  }
+
+  int sum = 0;
+  aligned.for_each([&](OverAlignedAsset &asset) { sum += asset.value; });
+  EXPECT_EQ(sum, 9 * 10 / 2);
+}
+
+TEST_F(ManagerTest, ColdTier) {
+  auto& manager = Manager<ColdAsset>::get();
+  manager.create("hot", 1);
+  manager.create("idle", 2);
+  manager.create("overwritten", 3);
+  manager.create("erased", 4);
+
+  // entries start out referenced, so the first pass only clears the bits
+  EXPECT_EQ(manager.cool(), 0);
+  EXPECT_TRUE(manager.find("hot"));
+  EXPECT_EQ(manager.cool(), 3);
+  EXPECT_EQ(manager.cold_size(), 3);
+  EXPECT_EQ(manager.size(), 1);
+
+  EXPECT_EQ(manager.find("idle")->value().value, 2);
+  EXPECT_EQ(ColdAsset::decoded, 1);
+  EXPECT_EQ(manager.cold_size(), 2);
+  EXPECT_EQ(manager.find("idle")->value().value, 2);
+  EXPECT_EQ(ColdAsset::decoded, 1);
+
+  manager.create("overwritten", 30);
+  EXPECT_EQ(manager.find("overwritten")->value().value, 30);
+  EXPECT_EQ(manager.erase("erased"), 1);
+  EXPECT_FALSE(manager.find("erased"));
+  EXPECT_EQ(manager.cold_size(), 0);
+  EXPECT_EQ(ColdAsset::decoded, 1);
+
+  manager.cool();
+  manager.cool();
+  EXPECT_EQ(manager.cold_size(), 3);
+  manager.clear();
+  EXPECT_EQ(manager.cold_size(), 0);
+  EXPECT_FALSE(manager.find("hot"));
+}
+
+TEST_F(ManagerTest, AssetGraphLoadsDependenciesFirst) {
+  auto& textures = Manager<GraphTexture>::get();
+  auto& materials = Manager<GraphMaterial>::get();
+  std::atomic<int> texture_loads = 0;
+  auto texture = [&](int value) {
+    return [&texture_loads, value] {
+      texture_loads++;
+      return GraphTexture {value};
+    };
+  };
+  auto material = [&](std::vector<std::string> ids) {
+    return [&textures, ids] {
+      int sum = 0;
+      for (const std::string &id : ids) {
+        sum += textures.find(id)->value().value;
+      }
+      return GraphMaterial {sum};
+    };
+  };
+
+  AssetGraph graph;
+  auto &t1 = graph.add<GraphTexture>("t1", texture(1));
+  auto &t2 = graph.add<GraphTexture>("t2", texture(2));
+  auto &m1 = graph.add<GraphMaterial>("m1", material({"t1", "t2"}));
+  auto &m2 = graph.add<GraphMaterial>("m2", material({"t2"}));
+  graph.depend(m1, t1);
+  graph.depend(m1, t2);
+  graph.depend(m2, t2);
+  EXPECT_EQ(&graph.add<GraphTexture>("t1", texture(10)), &t1);
+  EXPECT_EQ(graph.find<GraphMaterial>("m2"), &m2);
+  EXPECT_THROW(graph.depend(t2, m1), std::invalid_argument);
+
+  folly::CPUThreadPoolExecutor executor {4};
+  AssetGraph::Node *roots[] = {&m1, &m2};
+  graph.load(roots, folly::getKeepAliveToken(executor)).get();
+  EXPECT_EQ(texture_loads, 2);
+  EXPECT_EQ(materials.find("m1")->value().value, 3);
+  EXPECT_EQ(materials.find("m2")->value().value, 2);
+
+  EXPECT_EQ(graph.erase<GraphTexture>("t2"), 3);
+  EXPECT_FALSE(materials.find("m1"));
+  EXPECT_FALSE(materials.find("m2"));
+  graph.load(m1, folly::getKeepAliveToken(executor)).get();
+  EXPECT_EQ(texture_loads, 3);
+  EXPECT_EQ(materials.find("m1")->value().value, 3);
+
+  // removals are only recorded while the graph is watched
+  EXPECT_EQ(graph.cascade(), 0);
+  graph.watch();
+  // t2 is back, so only the removal of t1 cascades
+  textures.erase("t1");
+  EXPECT_EQ(graph.cascade(), 1);
+  EXPECT_FALSE(materials.find("m1"));
+  graph.unwatch();
+
+  auto &broken = graph.add<GraphTexture>("broken", []() -> GraphTexture { throw std::runtime_error("broken"); });
+  auto &m3 = graph.add<GraphMaterial>("m3", material({"broken"}));
+  graph.depend(m3, broken);
+  EXPECT_THROW(graph.load(m3, folly::getKeepAliveToken(executor)).get(), std::runtime_error);
+  EXPECT_FALSE(materials.find("m3"));
+}
+
+TEST_F(ManagerTest, AssetGraphSharesConcurrentLoads) {
+  std::atomic<int> texture_loads = 0;
+  AssetGraph graph;
+  auto &shared = graph.add<GraphTexture>("shared", [&] {
+    texture_loads++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return GraphTexture {1};
+  });
+  auto &a = graph.add<GraphMaterial>("a", [] { return GraphMaterial {1}; });
+  auto &b = graph.add<GraphMaterial>("b", [] { return GraphMaterial {2}; });
+  graph.depend(a, shared);
+  graph.depend(b, shared);
+
+  folly::CPUThreadPoolExecutor executor {4};
+  auto first = graph.load(a, folly::getKeepAliveToken(executor));
+  auto second = graph.load(b, folly::getKeepAliveToken(executor));
+  std::move(first).get();
+  std::move(second).get();
+  EXPECT_EQ(texture_loads, 1);
+  EXPECT_EQ(Manager<GraphMaterial>::get().find("a")->value().value, 1);
+  EXPECT_EQ(Manager<GraphMaterial>::get().find("b")->value().value, 2);
+}
+
+TEST(LatencyHistogramTest, Quantiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.quantile(0.5), 0);
+  histogram.buckets[4] = 90;
+  histogram.buckets[10] = 10;
+  EXPECT_EQ(histogram.samples(), 100);
+  EXPECT_EQ(histogram.quantile(0.5), 16);
+  EXPECT_EQ(histogram.quantile(0.99), 1024);
+}
+
+TEST_F(ManagerTest, SampledLatencies) {
+  auto& manager = Manager<TransformAsset>::get();
+  for (int i = 0; i < 1000; i++) {
+    manager.create("traced_" + std::to_string(i), i);
+    manager.find("traced_" + std::to_string(i));
+  }
+  manager.erase("traced_0");
+
+  LatencyHistograms latencies = manager.latencies();
+  auto find = static_cast<size_t>(TraceOp::find);
+  auto create = static_cast<size_t>(TraceOp::create);
+  if constexpr (MR_MANAGER_ENABLE_TRACING) {
+    EXPECT_GT(latencies[find].samples(), 0);
+    EXPECT_GT(latencies[create].samples(), 0);
+    EXPECT_GT(latencies[find].quantile(0.5), 0);
+  } else {
+    EXPECT_EQ(latencies[find].samples(), 0);
+    EXPECT_EQ(latencies[create].samples(), 0);
+  }
+}
+
+TEST_F(ManagerTest, PrefetchAndFindBatch) {
+  auto& manager = Manager<SnapshotAsset>::get();
+  std::vector<std::string> ids;
+  for (int i = 0; i < 20; i++) {
+    ids.push_back("batch_" + std::to_string(i));
+    if (i % 3 != 0) {
+      manager.create(ids.back(), i);
+    }
+  }
+  // only snapshot types have prefetch(), and before the first publish() it does nothing
+  manager.prefetch(ids);
+  manager.publish();
+  manager.prefetch(ids);
+  manager.prefetch("batch_missing");
+
+  std::vector<std::optional<Manager<SnapshotAsset>::Handle>> out(ids.size());
+  EXPECT_EQ(manager.find_batch(ids, out), 13);
+  for (int i = 0; i < 20; i++) {
+    ASSERT_EQ(out[i].has_value(), i % 3 != 0);
+    if (out[i]) {
+      EXPECT_EQ(out[i]->value().value, i);
+    }
+  }
+
+  std::vector<std::optional<Manager<TransformAsset>::Handle>> plain(1);
+  Manager<TransformAsset>::get().create("batch_plain", 1);
+  std::vector<std::string> plain_ids {"batch_plain"};
+  EXPECT_EQ(Manager<TransformAsset>::get().find_batch(plain_ids, plain), 1);
+  EXPECT_EQ(plain[0]->value().x, 1);
+}
+
+TEST(SlabResourceTest, HugePageUpstream) {
+  HugePageResource huge_pages;
+  SlabResource slab {64, 4096, 100, DefaultAssetPool::grow, &huge_pages};
+  for (int i = 0; i < 300; i++) {
+    void *block = slab.allocate(64, 64);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(block) % 4096, 0);
+    std::memset(block, i, 64);
+  }
+  EXPECT_EQ(slab.block_size(), 4096);
+  slab.release();
+  EXPECT_EQ(slab.capacity(), 0);
+}
+
+TEST_F(ManagerTest, ForEachVisitsLiveObjects) {
+  auto& manager = Manager<TransformAsset>::get();
+  for (int i = 0; i < 100; i++) {
+    manager.create("for_each_" + std::to_string(i), i);
+  }
+  auto erased = manager.create(unnamed, 100);
+  manager.create(unnamed, 101);
+  manager.erase(erased.id);
+  folly::hazptr_cleanup();
+
+  int count = 0, sum = 0;
+  manager.for_each([&](TransformAsset &asset) {
+    count++;
+    sum += asset.x;
+  });
+  EXPECT_EQ(count, 101);
+  EXPECT_EQ(sum, 99 * 100 / 2 + 101);
+
+  folly::CPUThreadPoolExecutor executor {4};
+  std::atomic<int> parallel_count = 0;
+  manager.parallel_for_each(folly::getKeepAliveToken(executor), [&](TransformAsset &asset) {
+    asset.x++;
+    parallel_count++;
+  }, 16);
+  EXPECT_EQ(parallel_count, 101);
+  EXPECT_EQ(manager.find("for_each_7")->value().x, 8);
+}
+
+TEST_F(ManagerTest, SaveAndLoadFile) {
+  auto& manager = Manager<StoredAsset>::get();
+  for (int i = 0; i < 100; i++) {
+    manager.create("stored_" + std::to_string(i), i, i * 0.5);
+  }
+  auto path = std::filesystem::temp_directory_path() / "mr-manager-test.bin";
+  manager.save_to(path);
+  manager.clear();
+  folly::hazptr_cleanup();
+  ASSERT_FALSE(manager.find("stored_7"));
+
+  std::size_t capacity = manager.stats().pool_capacity;
+  EXPECT_EQ(manager.load_from(path), 100);
+  EXPECT_EQ(manager.find("stored_7")->value().value, 7);
+  EXPECT_DOUBLE_EQ(manager.find("stored_99")->value().weight, 49.5);
+  // the mapped file is used as pool memory instead of a new arena
+  EXPECT_EQ(manager.stats().pool_capacity, capacity);
+
+  manager.erase("stored_7");
+  manager.create("stored_new", 1, 1.0);
+  EXPECT_EQ(manager.find("stored_new")->value().value, 1);
+
+  EXPECT_THROW(Manager<int>::get().load_from(path), std::runtime_error);
+  EXPECT_THROW(manager.load_from(path.string() + ".missing"), std::system_error);
+  std::filesystem::remove(path);
+}
+
+TEST_F(ManagerTest, LoadTruncatedIds) {
+  auto& manager = Manager<StoredAsset>::get();
+  for (int i = 0; i < 10; i++) {
+    manager.create("truncated_" + std::to_string(i), i, 1.0);
+  }
+  auto path = std::filesystem::temp_directory_path() / "mr-manager-truncated.bin";
+  manager.save_to(path);
+  manager.clear();
+  folly::hazptr_cleanup();
+
+  // cut the file in the middle of the id section, keeping the header consistent with its size
+  std::vector<char> bytes(std::filesystem::file_size(path));
+  std::ifstream {path, std::ios::binary}.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  detail::FileHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  header.bytes = header.ids + (header.bytes - header.ids) / 2;
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  bytes.resize(header.bytes);
+  std::ofstream {path, std::ios::binary | std::ios::trunc}.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+
+  EXPECT_THROW(manager.load_from(path), std::runtime_error);
+  EXPECT_EQ(manager.size(), 0);
+  EXPECT_FALSE(manager.find("truncated_0"));
+  // no block of the file was adopted as live pool memory
+  int live = 0;
+  manager.for_each([&](StoredAsset &) { live++; });
+  EXPECT_EQ(live, 0);
+  std::filesystem::remove(path);
+}
+
+TEST_F(ManagerTest, LoadCorruptHeaders) {
+  auto& manager = Manager<StoredAsset>::get();
+  for (int i = 0; i < 10; i++) {
+    manager.create("corrupt_" + std::to_string(i), i, 1.0);
+  }
+  auto path = std::filesystem::temp_directory_path() / "mr-manager-corrupt.bin";
+  manager.save_to(path);
+  manager.clear();
+  folly::hazptr_cleanup();
+
+  std::vector<char> saved(std::filesystem::file_size(path));
+  std::ifstream {path, std::ios::binary}.read(saved.data(), static_cast<std::streamsize>(saved.size()));
+  detail::FileHeader original;
+  std::memcpy(&original, saved.data(), sizeof(original));
+  ASSERT_TRUE(std::has_single_bit(original.block_size));
+
+  // writes the saved file back with its header changed by 'corrupt', cut to the header's size
+  auto rewrite = [&](auto corrupt) {
+    detail::FileHeader header = original;
+    corrupt(header);
+    std::vector<char> bytes = saved;
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    bytes.resize(std::min<std::uint64_t>(header.bytes, bytes.size()));
+    std::ofstream {path, std::ios::binary | std::ios::trunc}.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  };
+
+  // shorter than a header
+  rewrite([](detail::FileHeader &header) { header.bytes = 10; });
+  EXPECT_THROW(manager.load_from(path), std::runtime_error);
+  // cut in the middle of the objects
+  rewrite([](detail::FileHeader &header) { header.bytes = header.blocks + header.block_size; });
+  EXPECT_THROW(manager.load_from(path), std::runtime_error);
+  // objects overlapping the header
+  rewrite([](detail::FileHeader &header) {
+    header.blocks = 0;
+    header.ids = header.count * header.block_size;
+  });
+  EXPECT_THROW(manager.load_from(path), std::runtime_error);
+  // a count whose objects wrap around to no bytes at all, which must fail before anything is reserved
+  rewrite([](detail::FileHeader &header) {
+    header.count = std::numeric_limits<std::uint64_t>::max() / header.block_size + 1;
+    header.ids = header.blocks;
+  });
+  EXPECT_THROW(manager.load_from(path), std::runtime_error);
+  // more ids than the id section can hold
+  rewrite([](detail::FileHeader &header) {
+    header.count = (header.bytes - header.blocks) / header.block_size;
+    header.ids = header.blocks + header.count * header.block_size;
+  });
+  EXPECT_THROW(manager.load_from(path), std::runtime_error);
+
+  EXPECT_EQ(manager.size(), 0);
+  rewrite([](detail::FileHeader &) {});
+  EXPECT_EQ(manager.load_from(path), 10);
+  EXPECT_EQ(manager.find("corrupt_3")->value().value, 3);
+  std::filesystem::remove(path);
+}
+
+TEST_F(ManagerTest, ReplaceAndChangeQueue) {
+  auto& manager = Manager<ReloadableAsset>::get();
+  EXPECT_FALSE(manager.replace("reload_missing", 1));
+
+  auto changes = manager.subscribe();
+  auto old = manager.create("reload", 1);
+  auto fresh = manager.replace("reload", 2);
+  ASSERT_TRUE(fresh);
+  EXPECT_GT(fresh->version(), old.version());
+  // the old handle keeps the object it was taken from
+  EXPECT_EQ(old.value().value, 1);
+  EXPECT_EQ(manager.find("reload")->value().value, 2);
+  EXPECT_EQ(manager.find("reload")->version(), fresh->version());
+  manager.erase("reload");
+
+  std::vector<Manager<ReloadableAsset>::Change> seen;
+  EXPECT_EQ(changes.drain([&](const auto &change) { seen.push_back(change); }), 3);
+  ASSERT_EQ(seen.size(), 3);
+  EXPECT_EQ(seen[0].id, "reload");
+  EXPECT_EQ(seen[0].version, old.version());
+  EXPECT_EQ(seen[1].version, fresh->version());
+  EXPECT_EQ(seen[2].version, 0);
+  EXPECT_EQ(changes.drain([](const auto &) {}), 0);
+}
+
+TEST_F(ManagerTest, LookupCacheIsInvalidatedByWrites) {
+  auto& manager = Manager<CachedLookupAsset>::get();
+  EXPECT_EQ(manager.find_cached("cached"), nullptr);
+
+  manager.create("cached", 1);
+  CachedLookupAsset *first = manager.find_cached("cached");
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(manager.find_cached(std::string_view("cached")), first);
+
+  manager.replace("cached", 2);
+  EXPECT_EQ(manager.find_cached("cached")->value, 2);
+
+  std::thread other([&] { EXPECT_EQ(manager.find_cached("cached")->value, 2); });
+  other.join();
+
+  // slots point at the table's ids, not at the caller's
+  EXPECT_EQ(manager.find_cached(std::string("cached"))->value, 2);
+  EXPECT_EQ(manager.find_cached(std::string("cached"))->value, 2);
+
+  manager.erase("cached");
+  EXPECT_EQ(manager.find_cached("cached"), nullptr);
+  manager.create("cached", 3);
+  EXPECT_EQ(manager.find_cached("cached")->value, 3);
+}
+
+TEST(TransientManagerTest, ResetDropsEveryObject) {
+  auto& frame = TransientManager<FrameAsset>::get();
+  frame.reset();
+  FrameAsset::destroyed = 0;
+
+  auto first = frame.create(1);
+  TransientManager<FrameAsset>::Id other_id;
+  std::thread other([&] { other_id = frame.create(2).id; });
+  other.join();
+  for (int i = 0; i < 2000; i++) {
+    frame.create(i);
+  }
+  EXPECT_EQ(frame.size(), 2002);
+  EXPECT_EQ(frame.find(first.id)->value, 1);
+  // ids resolve from any thread, even after the creating one exited
+  EXPECT_EQ(frame.find(other_id)->value, 2);
+
+  frame.reset();
+  EXPECT_EQ(FrameAsset::destroyed, 2002);
+  EXPECT_EQ(frame.size(), 0);
+  EXPECT_EQ(frame.find(first.id), nullptr);
+  EXPECT_EQ(frame.find(other_id), nullptr);
+
+  // the arena's memory is reused
+  EXPECT_EQ(frame.create(3).ptr, first.ptr);
+}
+
+TEST(TransientManagerTest, ConstructsLikeManager) {
+  auto& frame = TransientManager<std::vector<int>>::get();
+  auto& manager = Manager<std::vector<int>>::get();
+  EXPECT_EQ(frame.create(3, 7).value(), manager.create("transient_braced", 3, 7).value());
+  EXPECT_EQ(frame.create(3, 7).value(), (std::vector<int> {3, 7}));
+  std::size_t size = 2;
+  EXPECT_EQ(frame.create(size, 7).value(), manager.create("transient_sized", size, 7).value());
+  frame.reset();
+  manager.clear();
+}
+
+TEST(TransientManagerTest, TriviallyDestructibleReset) {
+  auto& frame = TransientManager<int>::get();
+  auto handle = frame.create(7);
+  EXPECT_EQ(*frame.find(handle.id), 7);
+  frame.reset();
+  EXPECT_EQ(frame.find(handle.id), nullptr);
+  EXPECT_EQ(frame.size(), 0);
+}
+
 TEST_F(ManagerTest, ConcurrencyStressTest) {
   auto& manager = Manager<int>::get();
   const int num_threads = 4;